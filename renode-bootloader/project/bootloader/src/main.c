@@ -1,5 +1,7 @@
 #include <stdio.h>
 
+#include "boot_profile.h"
+#include "boot_validation_cache.h"
 #include "cmsis_shim.h"
 #include "hal/logging.h"
 #include "hal/uart.h"
@@ -54,6 +56,12 @@ static void do_boot(struct boot_rsp *rsp) {
   EXAMPLE_LOG("  Vector Table Start Address: 0x%x. PC=0x%x, SP=0x%x",
               (int)vector_table, app_start, app_sp);
 
+  // the application reinitializes the UART, finish the queued logs and stop
+  // its DMA and interrupts while this image's handlers are still the ones in
+  // the vector table
+  example_log_flush();
+  uart_deinit();
+
   // We need to move the vector table to reflect the location of the main
   // application
   volatile uint32_t *vtor = (uint32_t *)0xE000ED08;
@@ -66,6 +74,7 @@ static void do_boot(struct boot_rsp *rsp) {
 int main(void) {
   prv_enable_vfp();
   uart_boot();
+  boot_profile_init();
 
   // because a bootloader is a good opportunity for a little ASCII art!
   EXAMPLE_LOG("\n\n___  ________ _   _ _                 _   ");
@@ -78,7 +87,10 @@ int main(void) {
   EXAMPLE_LOG("==Starting Bootloader==");
 
   struct boot_rsp rsp;
-  int rv = boot_go(&rsp);
+  const uint32_t start = boot_profile_start();
+  int rv = boot_go_cached(&rsp);
+  boot_profile_stop(kBootProfileEvent_BootGo, start, 0);
+  boot_profile_dump();
 
   if (rv == 0) {
     do_boot(&rsp);
@@ -0,0 +1,62 @@
+#pragma once
+
+//! @file
+//! Cycle counter based timing of the flash port and boot phases. Each event
+//! accumulates a call count, bytes touched and cycles spent, and the table
+//! can be printed once boot_go() returns or from the "profile" shell command.
+//!
+//! On the NRF52 cycles come from the DWT cycle counter at 64MHz. Built
+//! natively, it counts nanoseconds from the monotonic clock instead.
+
+#include <stdint.h>
+
+//! Set to 0 to compile the timing out of the flash port
+#ifndef BOOT_PROFILE_ENABLED
+#define BOOT_PROFILE_ENABLED 1
+#endif
+
+typedef enum {
+  kBootProfileEvent_FlashRead = 0,
+  kBootProfileEvent_FlashWrite,
+  //! Bytes counts only the sectors actually erased, blank ones are skipped
+  kBootProfileEvent_FlashErase,
+  //! Reads deciding whether a sector needs erasing
+  kBootProfileEvent_BlankCheck,
+  //! Time inside tc_sha256_update(), only counted when the link wraps it
+  kBootProfileEvent_Sha256,
+  kBootProfileEvent_BootGo,
+
+  kBootProfileEvent_NumEvents,
+} eBootProfileEvent;
+
+typedef struct {
+  uint32_t count;
+  uint32_t bytes;
+  uint64_t cycles;
+  uint32_t max_cycles;
+} sBootProfileStat;
+
+//! Starts the cycle counter, call once before the first event
+void boot_profile_init(void);
+
+//! Current cycle count, pass to boot_profile_stop() when the event finishes
+uint32_t boot_profile_start(void);
+void boot_profile_stop(eBootProfileEvent event, uint32_t start, uint32_t bytes);
+
+const sBootProfileStat *boot_profile_get(eBootProfileEvent event);
+void boot_profile_reset(void);
+
+//! Logs one row per event with the time as a share of boot_go()
+void boot_profile_dump(void);
+
+#if BOOT_PROFILE_ENABLED
+#define BOOT_PROFILE_START() boot_profile_start()
+#define BOOT_PROFILE_STOP(event, start, bytes)                                 \
+  boot_profile_stop(event, start, bytes)
+#else
+#define BOOT_PROFILE_START() 0
+#define BOOT_PROFILE_STOP(event, start, bytes)                                 \
+  do {                                                                         \
+    (void)(start);                                                             \
+  } while (0)
+#endif
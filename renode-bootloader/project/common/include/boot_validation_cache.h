@@ -0,0 +1,38 @@
+#pragma once
+
+//! @file
+//! Remembers which primary slot image MCUboot last validated so an unchanged
+//! image can boot without hashing the whole slot again.
+//!
+//! Records are keyed by the image's SHA256 TLV and a generation counter that
+//! the flash port bumps before the first erase of the primary slot, or the
+//! first write below its last sector, in a boot. The last sector only holds
+//! MCUboot's trailer, so confirming an image keeps its record. A record only
+//! matches while the primary slot's image area has not been erased or written
+//! since the image was validated. Writes that bypass the flash port, such as
+//! a debugger reflashing the slot with an image carrying the same hash TLV,
+//! are not detected; anyone able to do that already controls the device.
+
+#include <stdbool.h>
+#include <stdint.h>
+
+struct boot_rsp;
+
+//! One sector after the secondary slot holds the generation and records
+#define BOOT_VALIDATION_CACHE_ADDRESS (288 * 1024)
+
+#define BOOT_VALIDATION_CACHE_HASH_SIZE 32
+
+//! Set to 0 to validate the primary slot on every boot
+#ifndef BOOT_VALIDATION_CACHE_ENABLED
+#define BOOT_VALIDATION_CACHE_ENABLED 1
+#endif
+
+//! boot_go(), but boots a primary slot image validated under the current
+//! generation straight away when no swap is pending. Records the image after
+//! boot_go() validates it.
+int boot_go_cached(struct boot_rsp *rsp);
+
+//! Drops every record, called by the flash port before an erase of the
+//! primary slot or a write to its image area
+void boot_validation_cache_invalidate(void);
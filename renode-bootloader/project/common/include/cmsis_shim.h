@@ -7,6 +7,24 @@
 
 #define __enable_irq() __asm("cpsie i" : : : "memory")
 #define __disable_irq() __asm("cpsid i" : : : "memory")
+
+static inline unsigned int __get_PRIMASK(void) {
+  unsigned int primask;
+  __asm volatile("mrs %0, primask" : "=r"(primask));
+  return primask;
+}
+
+static inline void __set_PRIMASK(unsigned int primask) {
+  __asm volatile("msr primask, %0" : : "r"(primask) : "memory");
+}
+
+//! Active exception number, 0 in thread mode
+static inline unsigned int __get_IPSR(void) {
+  unsigned int ipsr;
+  __asm volatile("mrs %0, ipsr" : "=r"(ipsr));
+  return ipsr;
+}
+
 #define __IM volatile const
 #define __OM volatile
 #define __IOM volatile
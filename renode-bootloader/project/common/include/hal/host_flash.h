@@ -0,0 +1,35 @@
+#pragma once
+
+//! @file
+//! A file backed stand-in for the NRF52 internal flash, for running the
+//! MCUboot port natively. Implements hal/internal_flash.h with NOR semantics:
+//! erase sets a whole sector to 0xff and programming can only clear bits.
+
+#include <stddef.h>
+#include <stdint.h>
+
+#define HOST_FLASH_SECTOR_SIZE 4096
+
+typedef struct {
+  uint32_t writes;
+  uint32_t bytes_written;
+  uint32_t sector_erases;
+  //! Programmed bytes that tried to set a bit back to 1. Real NOR flash
+  //! leaves those bits at 0, so this is always a bug in the caller.
+  uint32_t program_conflicts;
+} sHostFlashStats;
+
+//! Maps `path` as the flash device, creating or growing it to `size` bytes.
+//! Bytes added to the file read as erased. Returns 0 on success.
+int host_flash_open(const char *path, size_t size);
+//! Flushes the mapping to the file and unmaps it
+void host_flash_close(void);
+
+//! Size of the mapped device in bytes
+size_t host_flash_size(void);
+
+//! Number of times the sector holding `addr` was erased since open
+uint32_t host_flash_erase_count(uint32_t addr);
+
+void host_flash_get_stats(sHostFlashStats *stats);
+void host_flash_reset_stats(void);
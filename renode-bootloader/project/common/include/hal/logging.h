@@ -1,8 +1,65 @@
 #pragma once
 
+#include <stdint.h>
+
+//! Set to 1 to log the format string address and the raw arguments instead
+//! of formatting on the device, scripts/decode_log.py turns the stream back
+//! into text using the ELF. Arguments are stored as 32 bit words, so 64 bit
+//! integers and doubles do not survive and %s only decodes strings in flash.
+#ifndef EXAMPLE_LOG_DEFERRED
+#define EXAMPLE_LOG_DEFERRED 0
+#endif
+
 void example_log(const char *fmt, ...);
 
+//! Queues a record for example_log_process(), `args` holds `num_args` words
+void example_log_deferred(const char *fmt, const uint32_t *args,
+                          uint32_t num_args);
+
+//! Sends queued deferred records to the UART, call when idle
+void example_log_process(void);
+
+//! Sends everything logged so far and waits for the UART, e.g. before a
+//! reset or jumping to the application
+void example_log_flush(void);
+
+#if EXAMPLE_LOG_DEFERRED
+
+#define EXAMPLE_LOG_MAX_ARGS 8
+
+#define LOG_ARG_(x) (uint32_t)(uintptr_t)(x)
+#define LOG_ARGS_1_(a) LOG_ARG_(a)
+#define LOG_ARGS_2_(a, ...) LOG_ARG_(a), LOG_ARGS_1_(__VA_ARGS__)
+#define LOG_ARGS_3_(a, ...) LOG_ARG_(a), LOG_ARGS_2_(__VA_ARGS__)
+#define LOG_ARGS_4_(a, ...) LOG_ARG_(a), LOG_ARGS_3_(__VA_ARGS__)
+#define LOG_ARGS_5_(a, ...) LOG_ARG_(a), LOG_ARGS_4_(__VA_ARGS__)
+#define LOG_ARGS_6_(a, ...) LOG_ARG_(a), LOG_ARGS_5_(__VA_ARGS__)
+#define LOG_ARGS_7_(a, ...) LOG_ARG_(a), LOG_ARGS_6_(__VA_ARGS__)
+#define LOG_ARGS_8_(a, ...) LOG_ARG_(a), LOG_ARGS_7_(__VA_ARGS__)
+
+#define LOG_NARGS_(_1, _2, _3, _4, _5, _6, _7, _8, n, ...) n
+#define LOG_NARGS(...)                                                         \
+  LOG_NARGS_(__VA_ARGS__ __VA_OPT__(, ) 8, 7, 6, 5, 4, 3, 2, 1, 0)
+
+#define LOG_CAT_(a, b) a##b
+#define LOG_CAT(a, b) LOG_CAT_(a, b)
+#define LOG_ARGS(...) LOG_CAT(LOG_ARGS_, LOG_CAT(LOG_NARGS(__VA_ARGS__), _))(__VA_ARGS__)
+
+//! Costs the argument stores and a short copy into the log ring
+#define EXAMPLE_LOG(fmt, ...)                                                  \
+  do {                                                                         \
+    example_log_deferred(                                                      \
+        fmt,                                                                   \
+        (const uint32_t[LOG_NARGS(__VA_ARGS__) + 1]){                          \
+            __VA_OPT__(LOG_ARGS(__VA_ARGS__))},                                \
+        LOG_NARGS(__VA_ARGS__));                                               \
+  } while (0)
+
+#else
+
 #define EXAMPLE_LOG(...)                            \
   do {                                              \
     example_log(__VA_ARGS__);                       \
   } while (0)
+
+#endif
@@ -1,8 +1,35 @@
 #pragma once
 
 #include <stddef.h>
+#include <stdint.h>
 
 void uart_boot(void);
+//! Stops receive, transmit and the idle timer and disables their interrupts,
+//! so no DMA or handler touches this image's RAM after jumping to another.
+//! Anything still queued for transmit is dropped, flush first.
+void uart_deinit(void);
+
+//! Queues `len` bytes for transmit and returns once they are copied, only
+//! waiting for room in the transmit buffer. Messages shorter than the buffer
+//! go out whole. Safe from interrupts; one that preempts another uart_tx()
+//! and finds no room drops its message rather than wait on the call it
+//! interrupted.
+void uart_tx(const void *buf, size_t len);
+//! Waits until everything queued has been sent, e.g. before a reset or
+//! jumping to the application
+void uart_tx_flush(void);
+//! uart_tx() followed by uart_tx_flush()
 void uart_tx_blocking(void *buf, size_t len);
 
-extern void uart_byte_received_from_isr_cb(char c);
+//! Copies up to `len` received bytes into `buf` without blocking, returns
+//! how many were copied. Only one context may read.
+size_t uart_rx(void *buf, size_t len);
+//! Bytes dropped because the receive ring was full
+uint32_t uart_rx_dropped(void);
+
+//! Stops the receiver so flow control holds the sender, before the CPU
+//! stalls long enough to overrun the receive buffers, like a flash page
+//! erase. Bytes already received stay readable with uart_rx().
+void uart_rx_pause(void);
+//! Restarts the receiver after uart_rx_pause()
+void uart_rx_resume(void);
@@ -67,6 +67,10 @@
 /* #define MCUBOOT_USE_MBED_TLS */
 /* Uncomment to use Tinycrypt's. */
 /* #define MCUBOOT_USE_TINYCRYPT */
+/* MCUboot can also hash on the nRF52840 CryptoCell with MCUBOOT_USE_CC310,
+ * which needs Nordic's closed nrf_cc310_bl library and is not modelled by
+ * Renode. Instead boot_go_cached() (boot_validation_cache.h) skips hashing
+ * a primary slot image that was already validated. */
 
 /*
  * Always check the signature of the image in the primary slot before booting,
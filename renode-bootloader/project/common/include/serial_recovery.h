@@ -0,0 +1,51 @@
+#pragma once
+
+//! @file
+//! Streams an image over the UART into the secondary slot. A host tool
+//! (scripts/serial_upload.py) sends framed chunks with a CRC32 and keeps a
+//! window of them in flight, so the UART keeps receiving into the RX ring
+//! while the previous chunk is programmed. While a sector is erased the
+//! receiver is stopped and hardware flow control holds the host.
+//!
+//! All fields are little endian. Host to device:
+//!
+//!   u8  sync[2]  0xA5 0x5A
+//!   u8  type     SERIAL_RECOVERY_DATA, _END or _ABORT
+//!   u8  reserved
+//!   u32 offset   DATA: slot offset of the payload, END: image size
+//!   u16 len      payload length, DATA at most SERIAL_RECOVERY_MAX_CHUNK and
+//!                a multiple of 4 except for the last chunk, END 4
+//!   u16 reserved
+//!   u8  payload[len]   END: CRC32 of the whole image
+//!   u32 crc      CRC32 (zlib) of everything from type to the payload end
+//!
+//! Device to host, one per accepted, repeated or rejected frame:
+//!
+//!   u8  sync[2]  0xA5 0x5A
+//!   u8  status   SERIAL_RECOVERY_ACK, _NAK, _DONE or _FAIL
+//!   u8  reserved
+//!   u32 offset   next slot offset the device expects
+//!   u32 crc      CRC32 of status to offset
+//!
+//! The device only accepts DATA at the offset it expects. Repeats of data it
+//! already has are acked again, a gap or a bad CRC gets one NAK per offset,
+//! after which the host goes back to that offset. An ACK for offset 0 says
+//! the device is ready.
+
+#include <stdint.h>
+
+#define SERIAL_RECOVERY_MAX_CHUNK 256
+
+#define SERIAL_RECOVERY_DATA 1
+#define SERIAL_RECOVERY_END 2
+#define SERIAL_RECOVERY_ABORT 3
+
+#define SERIAL_RECOVERY_ACK 0
+#define SERIAL_RECOVERY_NAK 1
+#define SERIAL_RECOVERY_DONE 2
+#define SERIAL_RECOVERY_FAIL 3
+
+//! Receives an image into the secondary slot, returns 0 once it is written
+//! and its CRC read back from flash matches. Returns early on an ABORT frame,
+//! or a Ctrl-C sent after a good frame or before the first one.
+int serial_recovery_receive(void);
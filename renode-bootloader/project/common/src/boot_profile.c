@@ -0,0 +1,125 @@
+//! @file
+//!
+//! Boot latency profiling, see boot_profile.h
+
+#include "boot_profile.h"
+
+#include <stddef.h>
+#include <string.h>
+
+#include "hal/logging.h"
+
+#if defined(__arm__)
+
+#define DWT_CTRL (*(volatile uint32_t *)0xE0001000)
+#define DWT_CYCCNT (*(volatile uint32_t *)0xE0001004)
+#define DEMCR (*(volatile uint32_t *)0xE000EDFC)
+
+#define DEMCR_TRCENA (1 << 24)
+#define DWT_CTRL_CYCCNTENA (1 << 0)
+
+//! The NRF52840 core clock
+#define CYCLES_PER_US 64
+
+static void prv_cycle_counter_enable(void) {
+  DEMCR |= DEMCR_TRCENA;
+  DWT_CYCCNT = 0;
+  DWT_CTRL |= DWT_CTRL_CYCCNTENA;
+}
+
+static uint32_t prv_cycle_counter_read(void) {
+  return DWT_CYCCNT;
+}
+
+#else
+
+#include <time.h>
+
+#define CYCLES_PER_US 1000
+
+static void prv_cycle_counter_enable(void) {}
+
+static uint32_t prv_cycle_counter_read(void) {
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return (uint32_t)((uint64_t)ts.tv_sec * 1000000000u + (uint64_t)ts.tv_nsec);
+}
+
+#endif
+
+static sBootProfileStat s_stats[kBootProfileEvent_NumEvents];
+
+static const char *const s_event_names[kBootProfileEvent_NumEvents] = {
+    [kBootProfileEvent_FlashRead] = "flash read",
+    [kBootProfileEvent_FlashWrite] = "flash write",
+    [kBootProfileEvent_FlashErase] = "flash erase",
+    [kBootProfileEvent_BlankCheck] = "blank check",
+    [kBootProfileEvent_Sha256] = "sha256",
+    [kBootProfileEvent_BootGo] = "boot_go",
+};
+
+void boot_profile_init(void) {
+  prv_cycle_counter_enable();
+  boot_profile_reset();
+}
+
+uint32_t boot_profile_start(void) {
+  return prv_cycle_counter_read();
+}
+
+void boot_profile_stop(eBootProfileEvent event, uint32_t start,
+                       uint32_t bytes) {
+  // unsigned math keeps the delta right across one counter wrap, 67s at 64MHz
+  const uint32_t cycles = prv_cycle_counter_read() - start;
+  sBootProfileStat *stat = &s_stats[event];
+  stat->count++;
+  stat->bytes += bytes;
+  stat->cycles += cycles;
+  if (cycles > stat->max_cycles) {
+    stat->max_cycles = cycles;
+  }
+}
+
+const sBootProfileStat *boot_profile_get(eBootProfileEvent event) {
+  return &s_stats[event];
+}
+
+void boot_profile_reset(void) {
+  memset(s_stats, 0, sizeof(s_stats));
+}
+
+void boot_profile_dump(void) {
+  const uint64_t boot_cycles = s_stats[kBootProfileEvent_BootGo].cycles;
+
+  EXAMPLE_LOG("%-12s %8s %10s %10s %8s %6s", "event", "count", "bytes",
+              "total us", "max us", "boot%");
+  for (size_t i = 0; i < kBootProfileEvent_NumEvents; i++) {
+    const sBootProfileStat *stat = &s_stats[i];
+    // newlib's printf may lack 64 bit support, log 32 bit microseconds
+    const uint32_t total_us = (uint32_t)(stat->cycles / CYCLES_PER_US);
+    const uint32_t pct =
+        boot_cycles ? (uint32_t)(stat->cycles * 100 / boot_cycles) : 0;
+    EXAMPLE_LOG("%-12s %8lu %10lu %10lu %8lu %5lu%%", s_event_names[i],
+                (unsigned long)stat->count, (unsigned long)stat->bytes,
+                (unsigned long)total_us,
+                (unsigned long)(stat->max_cycles / CYCLES_PER_US),
+                (unsigned long)pct);
+  }
+}
+
+#if BOOT_PROFILE_WRAP_SHA256
+//! The build links with --wrap=tc_sha256_update so MCUboot's image hashing
+//! lands here without patching bootutil
+#include "tinycrypt/sha256.h"
+
+int __real_tc_sha256_update(TCSha256State_t s, const uint8_t *data,
+                            size_t datalen);
+
+int __wrap_tc_sha256_update(TCSha256State_t s, const uint8_t *data,
+                            size_t datalen) {
+  const uint32_t start = boot_profile_start();
+  const int rv = __real_tc_sha256_update(s, data, datalen);
+  boot_profile_stop(kBootProfileEvent_Sha256, start, datalen);
+  return rv;
+}
+#endif
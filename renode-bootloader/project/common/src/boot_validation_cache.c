@@ -0,0 +1,208 @@
+//! @file
+//!
+//! Validated image cache, see boot_validation_cache.h
+//!
+//! Sector layout, every word is programmed at most once between erases as
+//! the NVMC allows only two writes per word:
+//!
+//!   0x000       magic
+//!   0x004-0x0ff generation, one word cleared to 0 per increment
+//!   0x100-      records, appended in order
+
+#include "boot_validation_cache.h"
+
+#include <stddef.h>
+#include <string.h>
+
+#include "bootutil/bootutil.h"
+#include "bootutil/bootutil_public.h"
+#include "bootutil/image.h"
+#include "flash_map_backend/flash_map_backend.h"
+#include "hal/internal_flash.h"
+#include "hal/logging.h"
+#include "mcuboot_config/mcuboot_config.h"
+#include "sysflash/sysflash.h"
+
+#define CACHE_SECTOR_SIZE 4096
+#define CACHE_MAGIC 0x56434348 // "VCCH"
+#define CACHE_RECORD_MAGIC 0x56524543 // "VREC"
+
+#define CACHE_GENERATION_OFFSET 4
+#define CACHE_GENERATION_WORDS ((0x100 - CACHE_GENERATION_OFFSET) / 4)
+#define CACHE_RECORDS_OFFSET 0x100
+
+typedef struct {
+  uint32_t generation;
+  uint8_t hash[BOOT_VALIDATION_CACHE_HASH_SIZE];
+  //! Programmed last so a record torn by a reset never matches
+  uint32_t magic;
+} sValidationRecord;
+
+#define CACHE_NUM_RECORDS                                                      \
+  ((CACHE_SECTOR_SIZE - CACHE_RECORDS_OFFSET) / sizeof(sValidationRecord))
+
+//! Set once the generation has moved past the last record, so a swap erasing
+//! the whole slot bumps it once rather than per sector
+static bool s_invalidated;
+
+static uint32_t prv_read_word(uint32_t offset) {
+  uint32_t word;
+  example_internal_flash_read(BOOT_VALIDATION_CACHE_ADDRESS + offset, &word,
+                              sizeof(word));
+  return word;
+}
+
+static void prv_write_word(uint32_t offset, uint32_t word) {
+  example_internal_flash_write(BOOT_VALIDATION_CACHE_ADDRESS + offset, &word,
+                               sizeof(word));
+}
+
+static void prv_format(void) {
+  example_internal_flash_erase_sector(BOOT_VALIDATION_CACHE_ADDRESS);
+  prv_write_word(0, CACHE_MAGIC);
+}
+
+//! Number of generation words cleared, CACHE_GENERATION_WORDS when full
+static uint32_t prv_generation(void) {
+  uint32_t generation = 0;
+  while (generation < CACHE_GENERATION_WORDS &&
+         prv_read_word(CACHE_GENERATION_OFFSET + generation * 4) == 0) {
+    generation++;
+  }
+  return generation;
+}
+
+static void prv_read_record(size_t i, sValidationRecord *record) {
+  example_internal_flash_read(BOOT_VALIDATION_CACHE_ADDRESS +
+                                  CACHE_RECORDS_OFFSET + i * sizeof(*record),
+                              record, sizeof(*record));
+}
+
+void boot_validation_cache_invalidate(void) {
+  if (s_invalidated) {
+    return;
+  }
+  s_invalidated = true;
+
+  if (prv_read_word(0) != CACHE_MAGIC) {
+    prv_format();
+    return;
+  }
+
+  const uint32_t generation = prv_generation();
+  if (generation == CACHE_GENERATION_WORDS) {
+    // counter used up, erasing drops the records just as well
+    prv_format();
+    return;
+  }
+  prv_write_word(CACHE_GENERATION_OFFSET + generation * 4, 0);
+}
+
+static bool prv_lookup(const uint8_t *hash) {
+  if (prv_read_word(0) != CACHE_MAGIC) {
+    return false;
+  }
+
+  const uint32_t generation = prv_generation();
+  for (size_t i = 0; i < CACHE_NUM_RECORDS; i++) {
+    sValidationRecord record;
+    prv_read_record(i, &record);
+    if (record.magic == 0xffffffff) {
+      break;
+    }
+    if (record.magic == CACHE_RECORD_MAGIC &&
+        record.generation == generation &&
+        memcmp(record.hash, hash, sizeof(record.hash)) == 0) {
+      return true;
+    }
+  }
+  return false;
+}
+
+static void prv_record(const uint8_t *hash) {
+  if (prv_read_word(0) != CACHE_MAGIC) {
+    prv_format();
+  }
+
+  size_t i = 0;
+  for (; i < CACHE_NUM_RECORDS; i++) {
+    if (prv_read_word(CACHE_RECORDS_OFFSET + i * sizeof(sValidationRecord) +
+                      offsetof(sValidationRecord, magic)) == 0xffffffff) {
+      break;
+    }
+  }
+  if (i == CACHE_NUM_RECORDS) {
+    // keep the generation, every record before the erase belonged to it or
+    // to an older one
+    const uint32_t generation = prv_generation();
+    prv_format();
+    for (uint32_t g = 0; g < generation; g++) {
+      prv_write_word(CACHE_GENERATION_OFFSET + g * 4, 0);
+    }
+    i = 0;
+  }
+
+  sValidationRecord record = {
+      .generation = prv_generation(),
+      .magic = CACHE_RECORD_MAGIC,
+  };
+  memcpy(record.hash, hash, sizeof(record.hash));
+  // the HAL programs in address order, so magic lands last
+  example_internal_flash_write(BOOT_VALIDATION_CACHE_ADDRESS +
+                                   CACHE_RECORDS_OFFSET + i * sizeof(record),
+                               &record, sizeof(record));
+  s_invalidated = false;
+}
+
+//! Reads the SHA256 TLV of the primary slot image, the hash boot_go()
+//! checked the slot against
+static int prv_image_hash(const struct flash_area *fa,
+                          const struct image_header *hdr, uint8_t *hash) {
+  struct image_tlv_iter it;
+  if (bootutil_tlv_iter_begin(&it, hdr, fa, IMAGE_TLV_SHA256, false) != 0) {
+    return -1;
+  }
+
+  uint32_t off;
+  uint16_t len;
+  if (bootutil_tlv_iter_next(&it, &off, &len, NULL) != 0 ||
+      len != BOOT_VALIDATION_CACHE_HASH_SIZE) {
+    return -1;
+  }
+  return flash_area_read(fa, off, hash, len);
+}
+
+int boot_go_cached(struct boot_rsp *rsp) {
+  // a record only means something when boot_go() hashes the primary slot
+#if BOOT_VALIDATION_CACHE_ENABLED && defined(MCUBOOT_VALIDATE_PRIMARY_SLOT)
+  static struct image_header s_hdr;
+  uint8_t hash[BOOT_VALIDATION_CACHE_HASH_SIZE];
+  const struct flash_area *fa;
+  if (flash_area_open(FLASH_AREA_IMAGE_PRIMARY(0), &fa) != 0) {
+    return boot_go(rsp);
+  }
+
+  // a pending test, permanent or revert swap needs MCUboot
+  if (boot_swap_type() == BOOT_SWAP_TYPE_NONE &&
+      flash_area_read(fa, 0, &s_hdr, sizeof(s_hdr)) == 0 &&
+      s_hdr.ih_magic == IMAGE_MAGIC && prv_image_hash(fa, &s_hdr, hash) == 0 &&
+      prv_lookup(hash)) {
+    EXAMPLE_LOG("Primary slot image validated previously, skipping hash");
+    rsp->br_hdr = &s_hdr;
+    rsp->br_flash_dev_id = fa->fa_device_id;
+    rsp->br_image_off = fa->fa_off;
+    flash_area_close(fa);
+    return 0;
+  }
+
+  const int rv = boot_go(rsp);
+  if (rv == 0 && rsp->br_image_off == fa->fa_off &&
+      prv_image_hash(fa, rsp->br_hdr, hash) == 0) {
+    prv_record(hash);
+  }
+  flash_area_close(fa);
+  return rv;
+#else
+  return boot_go(rsp);
+#endif
+}
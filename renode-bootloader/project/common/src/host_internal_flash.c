@@ -0,0 +1,147 @@
+//! @file
+//!
+//! Host (Linux) implementation of the internal flash HAL backed by an mmap'd
+//! file. Device addresses are offsets into the file, matching the NRF52 where
+//! internal flash starts at 0x0.
+
+// The project builds with C extensions off, this exposes the POSIX calls
+#define _POSIX_C_SOURCE 200809L
+
+#include "hal/host_flash.h"
+#include "hal/internal_flash.h"
+
+#include <fcntl.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+static struct {
+  int fd;
+  uint8_t *base;
+  size_t size;
+  uint32_t *erase_counts;
+  sHostFlashStats stats;
+} s_flash = {
+    .fd = -1,
+};
+
+static void prv_check_range(const char *op, uint32_t addr, size_t length) {
+  if (s_flash.base == NULL || addr > s_flash.size ||
+      length > s_flash.size - addr) {
+    fprintf(stderr, "host flash: %s out of range, addr 0x%08x length %zu\n",
+            op, (unsigned)addr, length);
+    abort();
+  }
+}
+
+int host_flash_open(const char *path, size_t size) {
+  if (size == 0 || (size % HOST_FLASH_SECTOR_SIZE) != 0) {
+    return -1;
+  }
+
+  const int fd = open(path, O_RDWR | O_CREAT, 0644);
+  if (fd < 0) {
+    return -1;
+  }
+
+  struct stat st;
+  if (fstat(fd, &st) != 0) {
+    close(fd);
+    return -1;
+  }
+
+  const size_t old_size = (size_t)st.st_size;
+  if (old_size < size && ftruncate(fd, (off_t)size) != 0) {
+    close(fd);
+    return -1;
+  }
+
+  uint8_t *base = mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+  if (base == MAP_FAILED) {
+    close(fd);
+    return -1;
+  }
+
+  uint32_t *erase_counts =
+      calloc(size / HOST_FLASH_SECTOR_SIZE, sizeof(*erase_counts));
+  if (erase_counts == NULL) {
+    munmap(base, size);
+    close(fd);
+    return -1;
+  }
+
+  // ftruncate zero fills, a fresh part reads as erased
+  if (old_size < size) {
+    memset(base + old_size, 0xff, size - old_size);
+  }
+
+  s_flash.fd = fd;
+  s_flash.base = base;
+  s_flash.size = size;
+  s_flash.erase_counts = erase_counts;
+  host_flash_reset_stats();
+  return 0;
+}
+
+void host_flash_close(void) {
+  if (s_flash.base == NULL) {
+    return;
+  }
+  msync(s_flash.base, s_flash.size, MS_SYNC);
+  munmap(s_flash.base, s_flash.size);
+  close(s_flash.fd);
+  free(s_flash.erase_counts);
+  s_flash.fd = -1;
+  s_flash.base = NULL;
+  s_flash.size = 0;
+  s_flash.erase_counts = NULL;
+}
+
+size_t host_flash_size(void) {
+  return s_flash.size;
+}
+
+uint32_t host_flash_erase_count(uint32_t addr) {
+  prv_check_range(__func__, addr, 1);
+  return s_flash.erase_counts[addr / HOST_FLASH_SECTOR_SIZE];
+}
+
+void host_flash_get_stats(sHostFlashStats *stats) {
+  *stats = s_flash.stats;
+}
+
+void host_flash_reset_stats(void) {
+  memset(&s_flash.stats, 0, sizeof(s_flash.stats));
+}
+
+void example_internal_flash_write(uint32_t addr, const void *buf, size_t length) {
+  prv_check_range(__func__, addr, length);
+
+  const uint8_t *src = buf;
+  uint8_t *dst = s_flash.base + addr;
+  for (size_t i = 0; i < length; i++) {
+    if ((src[i] & ~dst[i]) != 0) {
+      s_flash.stats.program_conflicts++;
+    }
+    dst[i] &= src[i];
+  }
+  s_flash.stats.writes++;
+  s_flash.stats.bytes_written += length;
+}
+
+void example_internal_flash_read(uint32_t addr, void *buf, size_t length) {
+  prv_check_range(__func__, addr, length);
+  memcpy(buf, s_flash.base + addr, length);
+}
+
+void example_internal_flash_erase_sector(uint32_t addr) {
+  prv_check_range(__func__, addr, 1);
+  const uint32_t sector = addr / HOST_FLASH_SECTOR_SIZE;
+  memset(s_flash.base + sector * HOST_FLASH_SECTOR_SIZE, 0xff,
+         HOST_FLASH_SECTOR_SIZE);
+  s_flash.erase_counts[sector]++;
+  s_flash.stats.sector_erases++;
+}
@@ -4,15 +4,25 @@
 //! A minimal implementation of logging platform dependencies
 
 #include <stdarg.h>
+#include <stdbool.h>
+#include <stdint.h>
 #include <stdio.h>
+#include <string.h>
 
+#include "hal/logging.h"
 #include "hal/uart.h"
 
 static void prv_log(const char *fmt, va_list *args) {
   char log_buf[256];
-  const size_t size = vsnprintf(log_buf, sizeof(log_buf) - 1, fmt, *args);
+  const int rv = vsnprintf(log_buf, sizeof(log_buf) - 1, fmt, *args);
+  if (rv < 0) {
+    return;
+  }
+  // vsnprintf returns the untruncated length
+  const size_t size =
+      ((size_t)rv < sizeof(log_buf) - 1) ? (size_t)rv : sizeof(log_buf) - 2;
   log_buf[size] = '\n';
-  uart_tx_blocking(log_buf, size + 1);
+  uart_tx(log_buf, size + 1);
 }
 
 void example_log(const char *fmt, ...) {
@@ -21,3 +31,120 @@ void example_log(const char *fmt, ...) {
   prv_log(fmt, &args);
   va_end(args);
 }
+
+#if EXAMPLE_LOG_DEFERRED
+
+#include "cmsis_shim.h"
+
+//! Ring size in words, a record is 2 words plus one per argument
+#ifndef LOG_RING_WORDS
+#define LOG_RING_WORDS 256
+#endif
+
+_Static_assert((LOG_RING_WORDS & (LOG_RING_WORDS - 1)) == 0,
+              "LOG_RING_WORDS must be a power of 2");
+
+//! Frame on the wire, all fields little endian:
+//!   0xA5 0x4C, number of arguments, 0, format address, arguments
+//! A format address of 0 reports records lost to a full ring, its single
+//! argument is the count.
+#define LOG_FRAME_SYNC0 0xA5
+#define LOG_FRAME_SYNC1 0x4C
+#define LOG_FRAME_HEADER_LEN 8
+
+static struct {
+  uint32_t buf[LOG_RING_WORDS];
+  // Free running word indices, written with interrupts off by producers and
+  // only by example_log_process() for tail
+  volatile uint32_t head;
+  volatile uint32_t tail;
+  uint32_t dropped;
+} s_log;
+
+static void prv_send_frame(uint32_t fmt, const uint32_t *args,
+                           uint32_t num_args) {
+  uint8_t frame[LOG_FRAME_HEADER_LEN + EXAMPLE_LOG_MAX_ARGS * 4];
+  frame[0] = LOG_FRAME_SYNC0;
+  frame[1] = LOG_FRAME_SYNC1;
+  frame[2] = (uint8_t)num_args;
+  frame[3] = 0;
+  memcpy(&frame[4], &fmt, sizeof(fmt));
+  memcpy(&frame[LOG_FRAME_HEADER_LEN], args, num_args * sizeof(*args));
+  uart_tx(frame, LOG_FRAME_HEADER_LEN + num_args * sizeof(*args));
+}
+
+void example_log_deferred(const char *fmt, const uint32_t *args,
+                          uint32_t num_args) {
+  const uint32_t words = 2 + num_args;
+
+  const uint32_t primask = __get_PRIMASK();
+  __disable_irq();
+  const uint32_t head = s_log.head;
+  const bool fits = (LOG_RING_WORDS - (head - s_log.tail)) >= words;
+  if (fits) {
+    s_log.buf[head % LOG_RING_WORDS] = num_args;
+    s_log.buf[(head + 1) % LOG_RING_WORDS] = (uint32_t)(uintptr_t)fmt;
+    for (uint32_t i = 0; i < num_args; i++) {
+      s_log.buf[(head + 2 + i) % LOG_RING_WORDS] = args[i];
+    }
+    s_log.head = head + words;
+  } else {
+    s_log.dropped++;
+  }
+  __set_PRIMASK(primask);
+
+  // Long thread mode stretches without an idle loop, like an image swap,
+  // would otherwise fill the ring and drop records
+  const uint32_t used = s_log.head - s_log.tail;
+  if (__get_IPSR() == 0 && used > LOG_RING_WORDS / 2) {
+    example_log_process();
+  }
+}
+
+void example_log_process(void) {
+  // Producers in interrupts only write past head, so records between tail
+  // and head can be read without masking
+  uint32_t tail = s_log.tail;
+  while (tail != s_log.head) {
+    const uint32_t num_args = s_log.buf[tail % LOG_RING_WORDS];
+    const uint32_t fmt = s_log.buf[(tail + 1) % LOG_RING_WORDS];
+    uint32_t args[EXAMPLE_LOG_MAX_ARGS];
+    for (uint32_t i = 0; i < num_args; i++) {
+      args[i] = s_log.buf[(tail + 2 + i) % LOG_RING_WORDS];
+    }
+    tail += 2 + num_args;
+    s_log.tail = tail;
+    prv_send_frame(fmt, args, num_args);
+  }
+
+  const uint32_t primask = __get_PRIMASK();
+  __disable_irq();
+  const uint32_t dropped = s_log.dropped;
+  s_log.dropped = 0;
+  __set_PRIMASK(primask);
+  if (dropped != 0) {
+    prv_send_frame(0, &dropped, 1);
+  }
+}
+
+void example_log_flush(void) {
+  example_log_process();
+  uart_tx_flush();
+}
+
+#else
+
+void example_log_deferred(const char *fmt, const uint32_t *args,
+                          uint32_t num_args) {
+  (void)fmt;
+  (void)args;
+  (void)num_args;
+}
+
+void example_log_process(void) {}
+
+void example_log_flush(void) {
+  uart_tx_flush();
+}
+
+#endif
@@ -1,15 +1,19 @@
 /* Run the boot image. */
 
+#include <stdbool.h>
 #include <string.h>
 
 #include "flash_map_backend/flash_map_backend.h"
 #include "os/os_malloc.h"
 #include "sysflash/sysflash.h"
 
+#include "boot_profile.h"
+#include "boot_validation_cache.h"
 #include "hal/internal_flash.h"
 #include "hal/logging.h"
 
 #include "mcuboot_config/mcuboot_assert.h"
+#include "mcuboot_config/mcuboot_config.h"
 #include "mcuboot_config/mcuboot_logging.h"
 
 #define BOOTLOADER_START_ADDRESS 0x0
@@ -40,6 +44,10 @@ static const struct flash_area secondary_img0 = {
     .fa_size = APPLICATION_SIZE,
 };
 
+_Static_assert(BOOT_VALIDATION_CACHE_ADDRESS >=
+                  APPLICATION_SECONDARY_START_ADDRESS + APPLICATION_SIZE,
+              "validation cache overlaps the secondary slot");
+
 static const struct flash_area *s_flash_areas[] = {
     &bootloader,
     &primary_img0,
@@ -121,9 +129,147 @@ int flash_area_get_sectors(int fa_id, uint32_t *count,
   return 0;
 }
 
-//! Useful for bringup to make sure the write
-//! and erase operations are behaving as expected
-#define VALIDATE_PROGRAM_OP 1
+//! How much of each program and erase is read back to check the NVMC did its
+//! job. FULL compares every word, for bringup. SAMPLED checks the first and
+//! last word and one word every FLASH_VERIFY_SAMPLE_STRIDE bytes. NONE defers
+//! to MCUboot hashing the image, MCUBOOT_VALIDATE_PRIMARY_SLOT checks the
+//! primary slot after it changes. With the validated image cache that is not
+//! every boot, so a bit that later decays in an unchanged image goes unseen.
+//! The NVMC has no error status to consult instead, it only reports READY.
+#define FLASH_VERIFY_NONE 0
+#define FLASH_VERIFY_SAMPLED 1
+#define FLASH_VERIFY_FULL 2
+
+#ifndef FLASH_VERIFY_POLICY
+#define FLASH_VERIFY_POLICY FLASH_VERIFY_SAMPLED
+#endif
+
+#define FLASH_VERIFY_SAMPLE_STRIDE 256
+
+//! Skips erasing sectors that already read blank. Costs a 4kB read where an
+//! NRF52 page erase takes ~85ms, which adds up when a swap erases a whole
+//! slot for a small image. A sector left by an interrupted erase can read
+//! blank with weakly erased cells, set to 0 to always erase.
+#ifndef FLASH_SKIP_BLANK_ERASE
+#define FLASH_SKIP_BLANK_ERASE 1
+#endif
+
+#define MIN(a, b) ((a) < (b) ? (a) : (b))
+
+#if BOOT_VALIDATION_CACHE_ENABLED
+//! With swap using move the slot's last sector holds MCUboot's trailer and
+//! never image data: up to 3 status entries per image sector plus the swap
+//! info, image_ok and magic, each padded to a write of at most 8 bytes here
+_Static_assert(MCUBOOT_MAX_IMG_SECTORS * 3 * 8 + 8 * 8 <= FLASH_SECTOR_SIZE,
+              "MCUboot trailer does not fit the last sector of the slot");
+
+//! Writes into the primary slot's image area retire the validated image
+//! cache. Trailer updates such as boot_set_confirmed() leave the image alone.
+static void prv_invalidate_validation_cache(const struct flash_area *fa,
+                                            uint32_t off) {
+  if (fa->fa_id == FLASH_AREA_IMAGE_PRIMARY(0) &&
+      off < fa->fa_size - FLASH_SECTOR_SIZE) {
+    boot_validation_cache_invalidate();
+  }
+}
+#endif
+
+#if FLASH_SKIP_BLANK_ERASE || FLASH_VERIFY_POLICY != FLASH_VERIFY_NONE
+//! Word-wide blank check, addr and len must be word aligned
+static bool prv_flash_is_blank(uint32_t addr, uint32_t len) {
+  uint32_t chunk[16];
+  for (uint32_t i = 0; i < len; i += sizeof(chunk)) {
+    const uint32_t n = MIN(len - i, sizeof(chunk));
+    example_internal_flash_read(addr + i, chunk, n);
+    uint32_t all = 0xffffffff;
+    for (uint32_t j = 0; j < n / sizeof(chunk[0]); j++) {
+      all &= chunk[j];
+    }
+    if (all != 0xffffffff) {
+      return false;
+    }
+  }
+  return true;
+}
+#endif
+
+#if FLASH_SKIP_BLANK_ERASE
+#define FLASH_DEVICE_SIZE (1024 * 1024)
+#define FLASH_SECTOR_COUNT (FLASH_DEVICE_SIZE / FLASH_SECTOR_SIZE)
+
+//! Sectors known to be blank since they were last checked or erased. Only
+//! this port programs flash while the bootloader runs, so a set bit stays
+//! true until flash_area_write() touches the sector.
+static uint32_t s_blank_sectors[FLASH_SECTOR_COUNT / 32];
+
+static bool prv_sector_known_blank(uint32_t sector) {
+  return (s_blank_sectors[sector / 32] & (1u << (sector % 32))) != 0;
+}
+
+static void prv_set_sector_blank(uint32_t sector, bool blank) {
+  if (blank) {
+    s_blank_sectors[sector / 32] |= 1u << (sector % 32);
+  } else {
+    s_blank_sectors[sector / 32] &= ~(1u << (sector % 32));
+  }
+}
+
+static bool prv_sector_is_blank(uint32_t addr) {
+  const uint32_t sector = addr / FLASH_SECTOR_SIZE;
+  if (prv_sector_known_blank(sector)) {
+    return true;
+  }
+
+  const uint32_t start = BOOT_PROFILE_START();
+  const bool blank = prv_flash_is_blank(addr, FLASH_SECTOR_SIZE);
+  BOOT_PROFILE_STOP(kBootProfileEvent_BlankCheck, start, FLASH_SECTOR_SIZE);
+  prv_set_sector_blank(sector, blank);
+  return blank;
+}
+#endif
+
+#if FLASH_VERIFY_POLICY != FLASH_VERIFY_NONE
+//! Flash is read back through the HAL rather than dereferenced so the checks
+//! also run against the host flash backend
+static bool prv_flash_equals(uint32_t addr, const uint8_t *src, uint32_t len) {
+  uint32_t chunk[16];
+  for (uint32_t i = 0; i < len; i += sizeof(chunk)) {
+    const uint32_t n = MIN(len - i, sizeof(chunk));
+    example_internal_flash_read(addr + i, chunk, n);
+    if (memcmp(chunk, &src[i], n) != 0) {
+      return false;
+    }
+  }
+  return true;
+}
+
+static bool prv_verify_write(uint32_t addr, const uint8_t *src, uint32_t len) {
+#if FLASH_VERIFY_POLICY == FLASH_VERIFY_FULL
+  return prv_flash_equals(addr, src, len);
+#else
+  for (uint32_t off = 0; off < len; off += FLASH_VERIFY_SAMPLE_STRIDE) {
+    if (!prv_flash_equals(addr + off, &src[off], MIN(len - off, 4))) {
+      return false;
+    }
+  }
+  const uint32_t tail = len > 4 ? len - 4 : 0;
+  return prv_flash_equals(addr + tail, &src[tail], len - tail);
+#endif
+}
+
+static bool prv_verify_erase(uint32_t addr, uint32_t len) {
+#if FLASH_VERIFY_POLICY == FLASH_VERIFY_FULL
+  return prv_flash_is_blank(addr, len);
+#else
+  for (uint32_t off = 0; off < len; off += FLASH_VERIFY_SAMPLE_STRIDE) {
+    if (!prv_flash_is_blank(addr + off, 4)) {
+      return false;
+    }
+  }
+  return prv_flash_is_blank(addr + len - 4, 4);
+#endif
+}
+#endif
 
 int flash_area_read(const struct flash_area *fa, uint32_t off, void *dst,
                     uint32_t len) {
@@ -138,9 +284,10 @@ int flash_area_read(const struct flash_area *fa, uint32_t off, void *dst,
     return -1;
   }
 
-  // internal flash is memory mapped so just dereference the address
-  void *addr = (void *)(fa->fa_off + off);
-  memcpy(dst, addr, len);
+  // internal flash is memory mapped on the target, the HAL read is a memcpy
+  const uint32_t start = BOOT_PROFILE_START();
+  example_internal_flash_read(fa->fa_off + off, dst, len);
+  BOOT_PROFILE_STOP(kBootProfileEvent_FlashRead, start, len);
 
   return 0;
 }
@@ -160,14 +307,27 @@ int flash_area_write(const struct flash_area *fa, uint32_t off, const void *src,
 
   const uint32_t addr = fa->fa_off + off;
   MCUBOOT_LOG_DBG("%s: Addr: 0x%08x Length: %d", __func__, (int)addr, (int)len);
+
+#if BOOT_VALIDATION_CACHE_ENABLED
+  prv_invalidate_validation_cache(fa, off);
+#endif
+
+  const uint32_t start = BOOT_PROFILE_START();
   example_internal_flash_write(addr, src, len);
+#if FLASH_SKIP_BLANK_ERASE
+  for (uint32_t sector = addr / FLASH_SECTOR_SIZE;
+       len != 0 && sector <= (addr + len - 1) / FLASH_SECTOR_SIZE; sector++) {
+    prv_set_sector_blank(sector, false);
+  }
+#endif
 
-#if VALIDATE_PROGRAM_OP
-  if (memcmp((void *)addr, src, len) != 0) {
+#if FLASH_VERIFY_POLICY != FLASH_VERIFY_NONE
+  if (!prv_verify_write(addr, src, len)) {
     MCUBOOT_LOG_ERR("%s: Program Failed", __func__);
     assert(0);
   }
 #endif
+  BOOT_PROFILE_STOP(kBootProfileEvent_FlashWrite, start, len);
 
   return 0;
 }
@@ -187,25 +347,41 @@ int flash_area_erase(const struct flash_area *fa, uint32_t off, uint32_t len) {
   MCUBOOT_LOG_DBG("%s: Addr: 0x%08x Length: %d", __func__, (int)start_addr,
                   (int)len);
 
+#if BOOT_VALIDATION_CACHE_ENABLED
+  if (fa->fa_id == FLASH_AREA_IMAGE_PRIMARY(0)) {
+    boot_validation_cache_invalidate();
+  }
+#endif
+
+  const uint32_t start = BOOT_PROFILE_START();
+  uint32_t erased = 0;
   for (size_t i = 0; i < len; i += FLASH_SECTOR_SIZE) {
     const uint32_t addr = start_addr + i;
+#if FLASH_SKIP_BLANK_ERASE
+    if (prv_sector_is_blank(addr)) {
+      continue;
+    }
+#endif
     example_internal_flash_erase_sector(addr);
-  }
+    erased += FLASH_SECTOR_SIZE;
 
-#if VALIDATE_PROGRAM_OP
-  for (size_t i = 0; i < len; i++) {
-    uint8_t *val = (void *)(start_addr + i);
-    if (*val != 0xff) {
-      MCUBOOT_LOG_ERR("%s: Erase at 0x%x Failed", __func__, (int)val);
+#if FLASH_VERIFY_POLICY != FLASH_VERIFY_NONE
+    if (!prv_verify_erase(addr, FLASH_SECTOR_SIZE)) {
+      MCUBOOT_LOG_ERR("%s: Erase at 0x%x Failed", __func__, (int)addr);
       assert(0);
     }
-  }
 #endif
+#if FLASH_SKIP_BLANK_ERASE
+    prv_set_sector_blank(addr / FLASH_SECTOR_SIZE, true);
+#endif
+  }
+  BOOT_PROFILE_STOP(kBootProfileEvent_FlashErase, start, erased);
 
   return 0;
 }
 
 void example_assert_handler(const char *file, int line) {
   EXAMPLE_LOG("ASSERT: File: %s Line: %d", file, line);
+  example_log_flush();
   __builtin_trap();
 }
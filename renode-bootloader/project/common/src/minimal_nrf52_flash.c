@@ -17,6 +17,14 @@
 #define NVMC_READY_READY_Busy (0UL) /*!< NVMC is busy (on-going write or erase operation) */
 #define NVMC_READY_READY_Ready (1UL) /*!< NVMC is ready */
 
+/* Bit 0 : NVMC can accept a new write operation */
+#define NVMC_READYNEXT_READYNEXT_Pos (0UL) /*!< Position of READYNEXT field. */
+#define NVMC_READYNEXT_READYNEXT_Msk (0x1UL << NVMC_READYNEXT_READYNEXT_Pos) /*!< Bit mask of READYNEXT field. */
+#define NVMC_READYNEXT_READYNEXT_Busy (0UL) /*!< NVMC cannot accept any write operation */
+#define NVMC_READYNEXT_READYNEXT_Ready (1UL) /*!< NVMC is ready */
+
+#define MIN(a, b) ((a) < (b) ? (a) : (b))
+
 typedef struct {
   __IM  uint32_t  RESERVED[256];
   __IM  uint32_t  READY;
@@ -52,31 +60,74 @@ static void prv_wait_for_flash_read(void) {
     }
 }
 
-static void prv_write_byte(uint32_t address, uint8_t value) {
-  uint32_t byte_shift = address & (uint32_t)0x03;
-  uint32_t address32 = address & ~byte_shift; // Address to the word this byte is in.
-  uint32_t value32 = (*(uint32_t*)address32 & ~((uint32_t)0xFF << (byte_shift << (uint32_t)3)));
-  value32 = value32 + ((uint32_t)value << (byte_shift << 3));
+//! An idle NVMC can always take the next write, so READY ends the wait too.
+//! Renode has no NVMC model, only the SVD registers, where READY resets to
+//! Ready but READYNEXT has no reset value and would read Busy forever.
+static void prv_wait_for_write_ready_next(void) {
+  while (NRF_NVMC->READYNEXT == NVMC_READYNEXT_READYNEXT_Busy &&
+         NRF_NVMC->READY == NVMC_READY_READY_Busy) {
+  }
+}
 
-  // Enable write.
-  NRF_NVMC->CONFIG = (NVMC_CONFIG_WEN_Wen << NVMC_CONFIG_WEN_Pos);
+static void prv_set_config(uint32_t wen) {
+  NRF_NVMC->CONFIG = (wen << NVMC_CONFIG_WEN_Pos);
   __ISB();
   __DSB();
+}
 
-  *(uint32_t*)address32 = value32;
-  prv_wait_for_flash_read();
+//! Programs one word. Bits can only be cleared so 0xff bytes leave the
+//! flash contents untouched, which is how partial words are written.
+static void prv_write_word(uint32_t address32, uint32_t value32) {
+  *(volatile uint32_t *)address32 = value32;
+  // The NVMC buffers one write, so the next one can be issued as soon as
+  // READYNEXT is set rather than waiting for this one to complete
+  prv_wait_for_write_ready_next();
+}
 
-  NRF_NVMC->CONFIG = (NVMC_CONFIG_WEN_Ren << NVMC_CONFIG_WEN_Pos);
-  __ISB();
-  __DSB();
+//! Writes the bytes of buf that fall within the word at address32, starting
+//! byte_offset bytes in
+static void prv_write_partial_word(uint32_t address32, size_t byte_offset,
+                                   const uint8_t *buf, size_t length) {
+  uint32_t value32 = 0xFFFFFFFF;
+  memcpy((uint8_t *)&value32 + byte_offset, buf, length);
+  prv_write_word(address32, value32);
 }
 
 void example_internal_flash_write(uint32_t addr, const void *buf, size_t length) {
-  // NOTE: It would be more efficient to write out words when possible
+  if (length == 0) {
+    return;
+  }
   const uint8_t *buf_in = (const uint8_t *)buf;
-  for (size_t i = 0; i < length; i++) {
-    prv_write_byte(addr + i, buf_in[i]);
+
+  // Write mode is enabled once for the whole buffer. Each word is written
+  // once, the NVMC only allows a limited number of writes to a word between
+  // erases.
+  prv_set_config(NVMC_CONFIG_WEN_Wen);
+
+  // Unaligned head
+  const size_t head_offset = addr & 0x3;
+  if (head_offset != 0) {
+    const size_t head_len = MIN(4 - head_offset, length);
+    prv_write_partial_word(addr - head_offset, head_offset, buf_in, head_len);
+    addr += head_len;
+    buf_in += head_len;
+    length -= head_len;
   }
+
+  // Aligned words, buf_in may not be word aligned so copy each one out
+  for (; length >= 4; addr += 4, buf_in += 4, length -= 4) {
+    uint32_t value32;
+    memcpy(&value32, buf_in, sizeof(value32));
+    prv_write_word(addr, value32);
+  }
+
+  // Unaligned tail
+  if (length != 0) {
+    prv_write_partial_word(addr, 0, buf_in, length);
+  }
+
+  prv_wait_for_flash_read();
+  prv_set_config(NVMC_CONFIG_WEN_Ren);
 }
 
 void example_internal_flash_read(uint32_t addr, void *buf, size_t length) {
@@ -86,15 +137,11 @@ void example_internal_flash_read(uint32_t addr, void *buf, size_t length) {
 #define FLASH_SECTOR_SIZE 4096
 void example_internal_flash_erase_sector(uint32_t addr) {
   // Enable erase.
-  NRF_NVMC->CONFIG = NVMC_CONFIG_WEN_Een;
-  __ISB();
-  __DSB();
+  prv_set_config(NVMC_CONFIG_WEN_Een);
 
   // Erase the page
   NRF_NVMC->ERASEPAGE = addr;
   prv_wait_for_flash_read();
 
-  NRF_NVMC->CONFIG = NVMC_CONFIG_WEN_Ren;
-  __ISB();
-  __DSB();
+  prv_set_config(NVMC_CONFIG_WEN_Ren);
 }
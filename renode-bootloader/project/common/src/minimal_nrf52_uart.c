@@ -3,6 +3,7 @@
 
 #include "hal/uart.h"
 
+#include <stdbool.h>
 #include <stdint.h>
 #include <stdio.h>
 #include <string.h>
@@ -72,7 +73,113 @@ typedef struct {
 
 static sNrfUarteConfig *const UARTE = ((sNrfUarteConfig *)0x40002000);
 
-static uint8_t s_rx_recv_buf[4];
+// What the parts of the NRF52 timer peripheral used here look like
+typedef struct {
+  __OM  uint32_t  TASKS_START;
+  __OM  uint32_t  TASKS_STOP;
+  __OM  uint32_t  TASKS_COUNT;
+  __OM  uint32_t  TASKS_CLEAR;
+  __IM  uint32_t  RESERVED[76];
+  __IOM uint32_t  EVENTS_COMPARE[6];
+  __IM  uint32_t  RESERVED1[42];
+  __IOM uint32_t  SHORTS;
+  __IM  uint32_t  RESERVED2[64];
+  __IOM uint32_t  INTENSET;
+  __IOM uint32_t  INTENCLR;
+  __IM  uint32_t  RESERVED3[126];
+  __IOM uint32_t  MODE;
+  __IOM uint32_t  BITMODE;
+  __IM  uint32_t  RESERVED4;
+  __IOM uint32_t  PRESCALER;
+  __IM  uint32_t  RESERVED5[11];
+  __IOM uint32_t  CC[6];
+} sNrfTimerConfig;
+
+//! TIMER1 ticks the receive idle check
+static sNrfTimerConfig *const TIMER = ((sNrfTimerConfig *)0x40009000);
+#define TIMER_IRQ 9
+
+#define UARTE_IRQ 2
+
+#define UARTE_INT_ENDRX (1 << 4)
+#define UARTE_INT_ENDTX (1 << 8)
+#define UARTE_INT_RXTO (1 << 17)
+#define UARTE_INT_RXSTARTED (1 << 19)
+
+#define UARTE_SHORTS_ENDRX_STARTRX (1 << 5)
+
+//! BAUDRATE register values, hardware flow control is on so the top rate
+//! is usable for image upload
+#define UARTE_BAUDRATE_115200 0x01D60000
+#define UARTE_BAUDRATE_1000000 0x10000000
+
+#ifndef UART_BAUDRATE
+#define UART_BAUDRATE UARTE_BAUDRATE_115200
+#endif
+
+//! A partly filled receive buffer is handed over once the line has been
+//! quiet for between one and two ticks
+#define UART_RX_IDLE_TICK_US 500
+
+//! Polls of the receiver before giving up on RXTO after STOPRX, or ENDRX
+//! after FLUSHRX, a few ms at 64MHz against a few byte times for the event.
+//! A receiver that was already stopped, or a UARTE model without FLUSHRX,
+//! never sends them and the waits run with interrupts masked.
+#ifndef UART_RX_STOP_POLLS
+#define UART_RX_STOP_POLLS 100000
+#endif
+
+//! Receive is double buffered: EasyDMA fills one buffer while the next is
+//! already queued in RXD.PTR, and the ENDRX_STARTRX short moves between
+//! them without waiting for the interrupt.
+#define UART_RX_DMA_SIZE 64
+
+static struct {
+  uint8_t dma[2][UART_RX_DMA_SIZE];
+  //! Buffer EasyDMA is filling
+  volatile size_t active;
+  //! Bytes arrived since the last ENDRX, so a buffer is partly filled
+  volatile bool pending;
+  //! Set by uart_rx_pause(), RXTO leaves the receiver stopped
+  volatile bool paused;
+  //! The receiver stopped while paused
+  volatile bool stopped;
+} s_rx_dma;
+
+//! Single producer (the UARTE interrupt), single consumer (uart_rx()) ring.
+//! Indices run freely and are masked on use, each is written by one side
+//! only so no locking is needed. Sized to hold the three serial recovery
+//! frames the uploader keeps in flight while a chunk is programmed.
+#define UART_RX_RING_SIZE 1024
+
+static volatile struct {
+  uint8_t buf[UART_RX_RING_SIZE];
+  uint32_t head;
+  uint32_t tail;
+  uint32_t dropped;
+} s_rx;
+
+_Static_assert((UART_RX_RING_SIZE & (UART_RX_RING_SIZE - 1)) == 0,
+              "ring indices are masked");
+
+//! Transmit ring drained by EasyDMA. EasyDMA can only read RAM, so copying
+//! here also lets callers pass strings that live in flash.
+#define UART_TX_BUF_SIZE 1024
+
+static struct {
+  uint8_t buf[UART_TX_BUF_SIZE];
+  //! End of the space uart_tx() callers have claimed, copied into or not
+  volatile size_t reserve;
+  //! uart_tx() calls between claiming space and publishing it. A log from an
+  //! interrupt can preempt one, so only the last out moves head.
+  volatile size_t writers;
+  //! End of the bytes ready to send, only moved by uart_tx()
+  volatile size_t head;
+  //! First byte not yet sent, only moved when a transfer ends
+  volatile size_t tail;
+  //! Length of the transfer EasyDMA is running, 0 when idle
+  volatile size_t in_flight;
+} s_tx;
 
 static void prv_enable_nvic(int exti_id) {
   volatile uint32_t *nvic_ipr = (void *)(0xE000E400 + 4 * (exti_id / 4));
@@ -82,47 +189,328 @@ static void prv_enable_nvic(int exti_id) {
   *nvic_iser |= (1 << (exti_id % 32));
 }
 
+static void prv_disable_nvic(int exti_id) {
+  volatile uint32_t *nvic_icer = (void *)0xE000E180;
+  *nvic_icer = (1 << (exti_id % 32));
+
+  volatile uint32_t *nvic_icpr = (void *)0xE000E280;
+  *nvic_icpr = (1 << (exti_id % 32));
+}
+
+static void prv_rx_idle_timer_start(void) {
+  TIMER->MODE = 0;      // timer
+  TIMER->BITMODE = 3;   // 32 bit
+  TIMER->PRESCALER = 4; // 16MHz / 2^4, 1us ticks
+  TIMER->CC[0] = UART_RX_IDLE_TICK_US;
+  TIMER->SHORTS = 1;    // COMPARE0_CLEAR
+  TIMER->INTENSET = 1 << 16; // COMPARE0
+
+  prv_enable_nvic(TIMER_IRQ);
+  TIMER->TASKS_CLEAR = 1;
+  TIMER->TASKS_START = 1;
+}
+
 void uart_boot(void) {
   UARTE->PSEL.RTS = 5;
   UARTE->PSEL.TXD = 6;
   UARTE->PSEL.CTS = 7;
   UARTE->PSEL.RXD = 8;
 
-  UARTE->BAUDRATE = 0x01D60000; // 115200
+  UARTE->BAUDRATE = UART_BAUDRATE;
 
   // no parity, 1 stop bit, flow control
   UARTE->CONFIG = 1;
   UARTE->ENABLE = 8;
 
-  memset(s_rx_recv_buf, 0x0, sizeof(s_rx_recv_buf));
-  UARTE->RXD.PTR = (uint32_t)s_rx_recv_buf;
-  UARTE->RXD.MAXCNT = 1;
+  s_rx_dma.active = 0;
+  s_rx_dma.pending = false;
+  s_rx_dma.paused = false;
+  s_rx_dma.stopped = false;
+  UARTE->RXD.PTR = (uint32_t)s_rx_dma.dma[0];
+  UARTE->RXD.MAXCNT = UART_RX_DMA_SIZE;
+  UARTE->SHORTS = UARTE_SHORTS_ENDRX_STARTRX;
 
-  prv_enable_nvic(2);
-  UARTE->INTENSET |= (1 << 4);
+  prv_enable_nvic(UARTE_IRQ);
+  UARTE->INTENSET = UARTE_INT_ENDRX | UARTE_INT_ENDTX | UARTE_INT_RXTO |
+                    UARTE_INT_RXSTARTED;
   UARTE->TASKS_STARTRX = 1;
+
+  prv_rx_idle_timer_start();
 }
 
-void uart_tx_blocking(void *buf, size_t buf_len) {
+void uart_deinit(void) {
+  // masked so the handlers cannot restart receive or chain a transmit
+  const unsigned int primask = __get_PRIMASK();
+  __disable_irq();
+
+  TIMER->TASKS_STOP = 1;
+  TIMER->INTENCLR = 1 << 16; // COMPARE0
+  TIMER->EVENTS_COMPARE[0] = 0;
+
+  UARTE->INTENCLR = 0xffffffff;
+  UARTE->SHORTS = 0;
+  // a pending RXTO means an idle flush already stopped the receiver, and
+  // one stopped some other way never sends it
+  if (UARTE->EVENTS_RXTO == 0) {
+    UARTE->TASKS_STOPRX = 1;
+    for (uint32_t polls = 0;
+         UARTE->EVENTS_RXTO == 0 && polls < UART_RX_STOP_POLLS; polls++) {
+    }
+  }
+  UARTE->EVENTS_RXTO = 0;
+  UARTE->TASKS_STOPTX = 1;
+  UARTE->ENABLE = 0;
+
+  UARTE->EVENTS_ENDRX = 0;
+  UARTE->EVENTS_RXSTARTED = 0;
   UARTE->EVENTS_ENDTX = 0;
-  UARTE->EVENTS_TXSTOPPED = 0;
+  UARTE->EVENTS_ERROR = 0;
+
+  prv_disable_nvic(UARTE_IRQ);
+  prv_disable_nvic(TIMER_IRQ);
+  __set_PRIMASK(primask);
+}
+
+//! Producer side, only called from the UARTE interrupt or with interrupts
+//! masked
+static void prv_rx_push(const uint8_t *data, size_t len) {
+  uint32_t head = s_rx.head;
+  for (size_t i = 0; i < len; i++) {
+    if (head - s_rx.tail == UART_RX_RING_SIZE) {
+      s_rx.dropped += len - i;
+      break;
+    }
+    s_rx.buf[head & (UART_RX_RING_SIZE - 1)] = data[i];
+    head++;
+  }
+  // the bytes are stored before the consumer can see the new head
+  s_rx.head = head;
+}
 
-  UARTE->TXD.PTR = (uint32_t)buf;
-  UARTE->TXD.MAXCNT = buf_len;
+size_t uart_rx(void *buf, size_t len) {
+  uint8_t *dst = buf;
+  uint32_t tail = s_rx.tail;
+  size_t n = 0;
+  while (n < len && tail != s_rx.head) {
+    dst[n++] = s_rx.buf[tail & (UART_RX_RING_SIZE - 1)];
+    tail++;
+  }
+  s_rx.tail = tail;
+  return n;
+}
+
+uint32_t uart_rx_dropped(void) {
+  return s_rx.dropped;
+}
+
+static size_t prv_tx_reserved(void) {
+  return (s_tx.reserve + UART_TX_BUF_SIZE - s_tx.tail) % UART_TX_BUF_SIZE;
+}
 
+//! Starts EasyDMA on the queued bytes up to the end of the ring, the next
+//! ENDTX picks up any that wrapped. Called with interrupts masked.
+static void prv_tx_start(void) {
+  if (s_tx.in_flight != 0 || s_tx.head == s_tx.tail) {
+    return;
+  }
+
+  const size_t end = s_tx.head > s_tx.tail ? s_tx.head : UART_TX_BUF_SIZE;
+  s_tx.in_flight = end - s_tx.tail;
+
+  UARTE->EVENTS_ENDTX = 0;
+  UARTE->TXD.PTR = (uint32_t)&s_tx.buf[s_tx.tail];
+  UARTE->TXD.MAXCNT = s_tx.in_flight;
   UARTE->TASKS_STARTTX = 1;
+}
+
+//! Retires a finished transfer and chains the next one. Runs from the ENDTX
+//! interrupt, or polled with interrupts masked when the caller cannot wait
+//! for it.
+static void prv_tx_service(void) {
+  if (UARTE->EVENTS_ENDTX == 0) {
+    return;
+  }
+  UARTE->EVENTS_ENDTX = 0;
 
-  while (!UARTE->EVENTS_ENDTX && !UARTE->EVENTS_TXSTOPPED) {  }
+  s_tx.tail = (s_tx.tail + s_tx.in_flight) % UART_TX_BUF_SIZE;
+  s_tx.in_flight = 0;
+  prv_tx_start();
 }
 
-void Irq2_Handler(void) {
+//! Polls the transmitter, needed when interrupts are masked by the caller
+static void prv_tx_poll(void) {
+  const unsigned int primask = __get_PRIMASK();
+  __disable_irq();
+  prv_tx_service();
+  __set_PRIMASK(primask);
+}
+
+void uart_tx(const void *buf, size_t buf_len) {
+  const uint8_t *src = buf;
+  while (buf_len > 0) {
+    // one slot stays empty so head == tail only when the ring is empty
+    const size_t max = UART_TX_BUF_SIZE - 1;
+    const size_t n = buf_len < max ? buf_len : max;
+
+    // space is claimed with interrupts masked, so a log from an interrupt
+    // gets its own slots, and copied into with them enabled. Claiming all
+    // of it at once keeps the message whole.
+    const unsigned int primask = __get_PRIMASK();
+    __disable_irq();
+    if (max - prv_tx_reserved() < n) {
+      prv_tx_service();
+      // with nothing in flight the ring is all claimed and unpublished: this
+      // preempted another writer and waiting for it would never end
+      const bool stuck = s_tx.in_flight == 0;
+      __set_PRIMASK(primask);
+      if (stuck) {
+        return;
+      }
+      continue;
+    }
+    const size_t start = s_tx.reserve;
+    s_tx.reserve = (start + n) % UART_TX_BUF_SIZE;
+    s_tx.writers++;
+    __set_PRIMASK(primask);
+
+    const size_t to_end = UART_TX_BUF_SIZE - start;
+    const size_t first = n < to_end ? n : to_end;
+    memcpy(&s_tx.buf[start], src, first);
+    memcpy(&s_tx.buf[0], src + first, n - first);
+    src += n;
+    buf_len -= n;
+
+    __disable_irq();
+    if (--s_tx.writers == 0) {
+      s_tx.head = s_tx.reserve;
+      prv_tx_start();
+    }
+    __set_PRIMASK(primask);
+  }
+}
+
+void uart_tx_flush(void) {
+  while (s_tx.head != s_tx.tail) {
+    prv_tx_poll();
+  }
+}
+
+void uart_tx_blocking(void *buf, size_t buf_len) {
+  uart_tx(buf, buf_len);
+  uart_tx_flush();
+}
+
+//! Handles pending UARTE events. Runs from the interrupt, or polled with
+//! interrupts masked by uart_rx_pause().
+static void prv_uarte_service(void) {
   if (UARTE->EVENTS_ENDRX != 0) {
     UARTE->EVENTS_ENDRX = 0;
 
-    char c = s_rx_recv_buf[0];
-    uart_byte_received_from_isr_cb(c);
+    // with the short, EasyDMA has already moved on to the other buffer
+    const size_t done = s_rx_dma.active;
+    s_rx_dma.active ^= 1;
+    s_rx_dma.pending = false;
+    prv_rx_push(s_rx_dma.dma[done], UARTE->RXD.AMOUNT);
+  }
+
+  if (UARTE->EVENTS_RXSTARTED != 0) {
+    UARTE->EVENTS_RXSTARTED = 0;
+
+    // RXD.PTR is latched, queue the buffer that follows
+    UARTE->RXD.PTR = (uint32_t)s_rx_dma.dma[s_rx_dma.active ^ 1];
+  }
+
+  if (UARTE->EVENTS_RXTO != 0) {
+    UARTE->EVENTS_RXTO = 0;
+
+    if (s_rx_dma.paused) {
+      // RTS stays inactive, uart_rx_resume() restarts the receiver
+      s_rx_dma.stopped = true;
+      return;
+    }
 
-    // re-arm
+    // an idle flush stopped the receiver, pick up where it left off. The
+    // line was quiet, so nothing is left in the FIFO to flush.
+    UARTE->RXD.PTR = (uint32_t)s_rx_dma.dma[s_rx_dma.active];
+    UARTE->SHORTS = UARTE_SHORTS_ENDRX_STARTRX;
     UARTE->TASKS_STARTRX = 1;
   }
+
+  if (UARTE->EVENTS_ERROR != 0) {
+    UARTE->EVENTS_ERROR = 0;
+    // overrun or framing error, the bits are write 1 to clear
+    UARTE->ERRORSRC = UARTE->ERRORSRC;
+  }
+
+  prv_tx_service();
+}
+
+void Irq2_Handler(void) {
+  prv_uarte_service();
+}
+
+void uart_rx_pause(void) {
+  const unsigned int primask = __get_PRIMASK();
+  __disable_irq();
+  s_rx_dma.paused = true;
+  UARTE->SHORTS = 0;
+  UARTE->TASKS_STOPRX = 1;
+  // ENDRX hands over the partly filled buffer, then RXTO
+  for (uint32_t polls = 0; !s_rx_dma.stopped && polls < UART_RX_STOP_POLLS;
+       polls++) {
+    prv_uarte_service();
+  }
+  // without RXTO the receiver was not running, uart_rx_resume() starts it
+  s_rx_dma.stopped = true;
+  __set_PRIMASK(primask);
+}
+
+void uart_rx_resume(void) {
+  const unsigned int primask = __get_PRIMASK();
+  __disable_irq();
+  if (!s_rx_dma.paused) {
+    __set_PRIMASK(primask);
+    return;
+  }
+
+  // up to 4 bytes the sender had in flight when RTS dropped wait in the FIFO,
+  // FLUSHRX moves them to the buffer and ends it with ENDRX. Without ENDRX
+  // nothing is flushed and receive just starts again.
+  UARTE->RXD.PTR = (uint32_t)s_rx_dma.dma[s_rx_dma.active];
+  UARTE->EVENTS_ENDRX = 0;
+  UARTE->TASKS_FLUSHRX = 1;
+  for (uint32_t polls = 0;
+       UARTE->EVENTS_ENDRX == 0 && polls < UART_RX_STOP_POLLS; polls++) {
+  }
+  if (UARTE->EVENTS_ENDRX != 0) {
+    UARTE->EVENTS_ENDRX = 0;
+    prv_rx_push(s_rx_dma.dma[s_rx_dma.active], UARTE->RXD.AMOUNT);
+  }
+
+  s_rx_dma.paused = false;
+  s_rx_dma.stopped = false;
+  s_rx_dma.pending = false;
+  UARTE->SHORTS = UARTE_SHORTS_ENDRX_STARTRX;
+  UARTE->TASKS_STARTRX = 1;
+  __set_PRIMASK(primask);
+}
+
+//! Idle tick. RXDRDY is never enabled as an interrupt, the event register
+//! just records that a byte arrived since it was last cleared.
+void Irq9_Handler(void) {
+  TIMER->EVENTS_COMPARE[0] = 0;
+
+  if (UARTE->EVENTS_RXDRDY != 0) {
+    UARTE->EVENTS_RXDRDY = 0;
+    s_rx_dma.pending = true;
+    return;
+  }
+
+  if (s_rx_dma.pending) {
+    // quiet for a full tick, STOPRX ends the buffer early with ENDRX then
+    // RXTO. Without the short the receiver stays stopped until RXTO.
+    s_rx_dma.pending = false;
+    UARTE->SHORTS = 0;
+    UARTE->TASKS_STOPRX = 1;
+  }
 }
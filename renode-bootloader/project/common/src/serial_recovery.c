@@ -0,0 +1,245 @@
+//! @file
+//!
+//! Serial image upload into the secondary slot, see serial_recovery.h
+
+#include "serial_recovery.h"
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <string.h>
+
+#include "flash_map_backend/flash_map_backend.h"
+#include "hal/logging.h"
+#include "hal/uart.h"
+#include "sysflash/sysflash.h"
+
+#define SYNC0 0xA5
+#define SYNC1 0x5A
+#define CTRL_C 0x03
+
+#define HEADER_SIZE 12
+#define CRC_SIZE 4
+#define FLASH_SECTOR_SIZE 4096
+
+typedef struct {
+  uint8_t type;
+  uint32_t offset;
+  uint16_t len;
+  uint8_t payload[SERIAL_RECOVERY_MAX_CHUNK];
+} sRecoveryFrame;
+
+static uint32_t prv_crc32_update(uint32_t crc, const uint8_t *data,
+                                 size_t len) {
+  // nibble table, 64 bytes of flash against 1kB for a byte table
+  static const uint32_t s_table[16] = {
+      0x00000000, 0x1db71064, 0x3b6e20c8, 0x26d930ac, 0x76dc4190, 0x6b6b51f4,
+      0x4db26158, 0x5005713c, 0xedb88320, 0xf00f9344, 0xd6d6a3e8, 0xcb61b38c,
+      0x9b64c2b0, 0x86d3d2d4, 0xa00ae278, 0xbdbdf21c,
+  };
+  crc = ~crc;
+  for (size_t i = 0; i < len; i++) {
+    crc ^= data[i];
+    crc = (crc >> 4) ^ s_table[crc & 0xf];
+    crc = (crc >> 4) ^ s_table[crc & 0xf];
+  }
+  return ~crc;
+}
+
+static uint32_t prv_get_u32(const uint8_t *p) {
+  return p[0] | (p[1] << 8) | (p[2] << 16) | ((uint32_t)p[3] << 24);
+}
+
+static void prv_put_u32(uint8_t *p, uint32_t v) {
+  p[0] = v;
+  p[1] = v >> 8;
+  p[2] = v >> 16;
+  p[3] = v >> 24;
+}
+
+static uint8_t prv_getc(void) {
+  uint8_t c;
+  while (uart_rx(&c, 1) == 0) {
+  }
+  return c;
+}
+
+static void prv_read(uint8_t *buf, size_t len) {
+  size_t n = 0;
+  while (n < len) {
+    n += uart_rx(&buf[n], len - n);
+  }
+}
+
+static void prv_respond(uint8_t status, uint32_t offset) {
+  uint8_t rsp[12] = {SYNC0, SYNC1, status, 0};
+  prv_put_u32(&rsp[4], offset);
+  prv_put_u32(&rsp[8], prv_crc32_update(0, &rsp[2], 6));
+  uart_tx(rsp, sizeof(rsp));
+}
+
+//! Waits for the next frame. Returns false on Ctrl-C, a frame with a bad
+//! CRC or length comes back with type 0.
+//!
+//! Ctrl-C only counts as the first byte after a good frame, where the host
+//! would send a sync. After a bad frame the hunt for the next sync can run
+//! through image payload, where 0x03 is common.
+static bool prv_receive_frame(sRecoveryFrame *frame, bool at_boundary) {
+  uint8_t hdr[HEADER_SIZE];
+  uint8_t prev = 0;
+  bool first = true;
+  while (true) {
+    const uint8_t c = prv_getc();
+    if (c == CTRL_C && first && at_boundary) {
+      return false;
+    }
+    first = false;
+    if (prev == SYNC0 && c == SYNC1) {
+      break;
+    }
+    prev = c;
+  }
+
+  hdr[0] = SYNC0;
+  hdr[1] = SYNC1;
+  prv_read(&hdr[2], HEADER_SIZE - 2);
+  frame->type = hdr[2];
+  frame->offset = prv_get_u32(&hdr[4]);
+  frame->len = hdr[8] | (hdr[9] << 8);
+  if (frame->len > SERIAL_RECOVERY_MAX_CHUNK) {
+    // a corrupt length, resync on the next frame
+    frame->type = 0;
+    return true;
+  }
+
+  uint8_t crc[CRC_SIZE];
+  prv_read(frame->payload, frame->len);
+  prv_read(crc, sizeof(crc));
+  uint32_t expected = prv_crc32_update(0, &hdr[2], HEADER_SIZE - 2);
+  expected = prv_crc32_update(expected, frame->payload, frame->len);
+  if (expected != prv_get_u32(crc)) {
+    frame->type = 0;
+  }
+  return true;
+}
+
+//! Erases ahead of the write, a sector at a time, so programming starts
+//! without erasing the whole slot first. Running from flash, the CPU and the
+//! UART interrupt stall for each ~85ms page erase, so the receiver is paused
+//! and flow control holds the host's frames until the erase is done.
+static int prv_erase_to(const struct flash_area *fa, uint32_t *erased_end,
+                        uint32_t end) {
+  if (*erased_end >= end) {
+    return 0;
+  }
+
+  int rv = 0;
+  uart_rx_pause();
+  while (*erased_end < end) {
+    if (flash_area_erase(fa, *erased_end, FLASH_SECTOR_SIZE) != 0) {
+      rv = -1;
+      break;
+    }
+    *erased_end += FLASH_SECTOR_SIZE;
+  }
+  uart_rx_resume();
+  return rv;
+}
+
+static uint32_t prv_flash_crc32(const struct flash_area *fa, uint32_t len) {
+  uint8_t chunk[64];
+  uint32_t crc = 0;
+  for (uint32_t off = 0; off < len; off += sizeof(chunk)) {
+    const uint32_t n = (len - off) < sizeof(chunk) ? (len - off) : sizeof(chunk);
+    flash_area_read(fa, off, chunk, n);
+    crc = prv_crc32_update(crc, chunk, n);
+  }
+  return crc;
+}
+
+static int prv_finish(const struct flash_area *fa, uint32_t *erased_end,
+                      const sRecoveryFrame *frame, uint32_t expected) {
+  const uint32_t size = frame->offset;
+  if (frame->len != 4 || size != expected) {
+    EXAMPLE_LOG("Upload ended at 0x%x, 0x%x received", (int)size,
+                (int)expected);
+    return -1;
+  }
+
+  // old image data past the end, including its trailer, must not survive
+  if (prv_erase_to(fa, erased_end, fa->fa_size) != 0) {
+    return -1;
+  }
+
+  if (prv_flash_crc32(fa, size) != prv_get_u32(frame->payload)) {
+    EXAMPLE_LOG("Upload CRC mismatch");
+    return -1;
+  }
+  return 0;
+}
+
+int serial_recovery_receive(void) {
+  const struct flash_area *fa;
+  if (flash_area_open(FLASH_AREA_IMAGE_SECONDARY(0), &fa) != 0) {
+    return -1;
+  }
+
+  static sRecoveryFrame s_frame;
+  uint32_t expected = 0;
+  uint32_t erased_end = 0;
+  // the stream is aligned on a frame boundary, see prv_receive_frame()
+  bool frame_ok = true;
+  bool nak_sent = false;
+  int rv = -1;
+
+  prv_respond(SERIAL_RECOVERY_ACK, 0);
+
+  while (prv_receive_frame(&s_frame, frame_ok)) {
+    frame_ok = s_frame.type != 0;
+    if (s_frame.type == SERIAL_RECOVERY_ABORT) {
+      break;
+    }
+
+    if (s_frame.type == SERIAL_RECOVERY_END) {
+      rv = prv_finish(fa, &erased_end, &s_frame, expected);
+      prv_respond(rv == 0 ? SERIAL_RECOVERY_DONE : SERIAL_RECOVERY_FAIL,
+                  expected);
+      break;
+    }
+
+    if (s_frame.type == SERIAL_RECOVERY_DATA &&
+        s_frame.offset + s_frame.len <= expected) {
+      // the host went back further than needed, we already have this
+      prv_respond(SERIAL_RECOVERY_ACK, expected);
+      continue;
+    }
+
+    if (s_frame.type != SERIAL_RECOVERY_DATA || s_frame.offset != expected) {
+      // corrupt or out of order, ask once for a resend from expected
+      if (!nak_sent) {
+        prv_respond(SERIAL_RECOVERY_NAK, expected);
+        nak_sent = true;
+      }
+      continue;
+    }
+
+    // only the last chunk may be short of a whole word
+    if ((expected % 4) != 0 || expected + s_frame.len > fa->fa_size) {
+      prv_respond(SERIAL_RECOVERY_FAIL, expected);
+      break;
+    }
+
+    // frames behind this one keep landing in the RX ring while the chunk
+    // is programmed, a word at a time with the interrupt serviced between
+    if (prv_erase_to(fa, &erased_end, expected + s_frame.len) != 0 ||
+        flash_area_write(fa, expected, s_frame.payload, s_frame.len) != 0) {
+      prv_respond(SERIAL_RECOVERY_FAIL, expected);
+      break;
+    }
+    expected += s_frame.len;
+    nak_sent = false;
+    prv_respond(SERIAL_RECOVERY_ACK, expected);
+  }
+
+  flash_area_close(fa);
+  return rv;
+}
@@ -14,12 +14,16 @@
 #include <stdlib.h>
 #include <string.h>
 
+#include "boot_profile.h"
 #include "bootutil/bootutil.h"
 #include "hal/logging.h"
+#include "serial_recovery.h"
 
 #define ARRAY_SIZE(arr) (sizeof(arr) / sizeof(arr[0]))
 
 static void prv_reboot(void) {
+  example_log_flush();
+
   // NVIC_SystemReset
   *(volatile uint32_t *)0xE000ED0C = 0x5FAUL << 16 | 0x4;
 
@@ -80,10 +84,32 @@ static int cli_magic_number_check(int argc, char *argv[]) {
   return 0;
 }
 
+static int prv_profile_cli(int argc, char *argv[]) {
+  boot_profile_dump();
+  if (argc > 1 && strcmp(argv[1], "reset") == 0) {
+    boot_profile_reset();
+  }
+  return 0;
+}
+
+static int prv_upload_cli(int argc, char *argv[]) {
+  // the console is the transport until the upload ends
+  const int result = serial_recovery_receive();
+  example_log_flush();
+  if (result == 0) {
+    EXAMPLE_LOG("Image written to the secondary slot, 'swap_images' to boot it");
+  } else {
+    EXAMPLE_LOG("Upload failed");
+  }
+  return result;
+}
+
 static const sShellCommand s_shell_commands[] = {
     {"*IDN?", cli_idn, "Identity response"},
     {"MAGIC?", cli_magic_number_check, "Check magic numbers"},
     {"swap_images", prv_swap_images, "Swap images"},
+    {"upload", prv_upload_cli, "Receive an image into the secondary slot"},
+    {"profile", prv_profile_cli, "Boot timing table, 'profile reset' clears"},
     {"reboot", prv_reboot_cli, "Reboot System"},
     {"help", shell_help_handler, "Lists all commands"},
 };
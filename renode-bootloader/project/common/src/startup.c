@@ -67,6 +67,7 @@ static void HardFault_Handler(void) {
 
 void DebugMonitor_Exception(void);
 void Irq2_Handler(void);
+void Irq9_Handler(void);
 
 #define EXTERNAL_INT_BASE 16 // NVIC Interrupt 0 starts here
 // A minimal vector table for a Cortex M.
@@ -89,4 +90,5 @@ __attribute__((section(".isr_vector"))) void (*const g_pfnVectors[])(void) = {
     [15] = DefaultIntHandler,
     // NVIC Interrupts
     [16 + 2] = Irq2_Handler, // Uart
+    [16 + 9] = Irq9_Handler, // Uart receive idle timer
 };
@@ -0,0 +1,171 @@
+#!/usr/bin/env python3
+"""
+Decode the console of a build with EXAMPLE_LOG_DEFERRED=1 (hal/logging.h).
+
+Log records arrive as binary frames holding the address of the format string
+and the raw 32 bit arguments, the strings are read back out of the ELF the
+device runs. Console text between the frames, like the shell, is passed
+through unchanged.
+
+    python3 decode_log.py build/bootloader.elf /dev/ttyACM0 --baud 1000000
+    python3 decode_log.py build/bootloader.elf capture.bin
+"""
+import argparse
+import re
+import struct
+import sys
+
+SYNC = b"\xa5\x4c"
+HEADER_LEN = 8
+
+SHT_NOBITS = 8
+SHF_ALLOC = 0x2
+
+# flags, width, precision, length and conversion of a printf directive
+DIRECTIVE = re.compile(r"%([-+ #0]*)(\d+|\*)?(?:\.(\d+|\*))?(hh|h|ll|l|j|z|t|L)?([diouxXcsp%])")
+
+
+class Elf:
+    """Just enough ELF to read constant strings by their load address."""
+
+    def __init__(self, path):
+        with open(path, "rb") as f:
+            self.data = f.read()
+        if self.data[:4] != b"\x7fELF":
+            raise ValueError(f"{path} is not an ELF file")
+        is64 = self.data[4] == 2
+        endian = "<" if self.data[5] == 1 else ">"
+        if is64:
+            shoff, = struct.unpack_from(endian + "Q", self.data, 0x28)
+            shentsize, shnum = struct.unpack_from(endian + "HH", self.data, 0x3A)
+            section = endian + "IIQQQQIIQQ"
+        else:
+            shoff, = struct.unpack_from(endian + "I", self.data, 0x20)
+            shentsize, shnum = struct.unpack_from(endian + "HH", self.data, 0x2E)
+            section = endian + "IIIIIIIIII"
+
+        self.sections = []
+        for i in range(shnum):
+            _, sh_type, flags, addr, offset, size, *_ = struct.unpack_from(
+                section, self.data, shoff + i * shentsize)
+            if flags & SHF_ALLOC and sh_type != SHT_NOBITS and size:
+                self.sections.append((addr, size, offset))
+
+    def string(self, addr):
+        """The C string at addr, None when addr is not in a loaded section."""
+        for start, size, offset in self.sections:
+            if start <= addr < start + size:
+                begin = offset + addr - start
+                end = self.data.find(b"\0", begin, offset + size)
+                if end < 0:
+                    end = offset + size
+                return self.data[begin:end].decode("utf-8", "replace")
+        return None
+
+
+def format_record(elf, fmt_addr, args):
+    if fmt_addr == 0:
+        return f"<{args[0] if args else '?'} log records dropped>"
+    fmt = elf.string(fmt_addr)
+    if fmt is None:
+        return f"<unknown format 0x{fmt_addr:08x} {' '.join(f'0x{a:08x}' for a in args)}>"
+
+    remaining = list(args)
+
+    def next_arg():
+        return remaining.pop(0) if remaining else 0
+
+    def convert(m):
+        flags, width, precision, _, conv = m.groups()
+        if conv == "%":
+            return "%"
+        if width == "*":
+            width = str(next_arg())
+        if precision == "*":
+            precision = str(next_arg())
+        spec = "%" + flags + (width or "") + ("." + precision if precision is not None else "")
+        value = next_arg()
+        if conv in "di":
+            value = value - (1 << 32) if value & (1 << 31) else value
+            return (spec + "d") % value
+        if conv in "ouxX":
+            return (spec + conv) % value
+        if conv == "c":
+            return (spec + "c") % chr(value & 0xFF)
+        if conv == "p":
+            return (spec + "s") % f"0x{value:x}"
+        s = elf.string(value)
+        return (spec + "s") % (s if s is not None else f"<str 0x{value:08x}>")
+
+    return DIRECTIVE.sub(convert, fmt)
+
+
+def decode(elf, read, write):
+    """Copies console text to write() and replaces each frame with its text,
+    read(n) returns up to n bytes and b"" at the end of the stream."""
+    pending = b""
+    while True:
+        chunk = read(256)
+        if not chunk:
+            break
+        pending += chunk
+        while True:
+            start = pending.find(SYNC)
+            if start < 0:
+                # a trailing sync byte can be the start of a split frame
+                keep = 1 if pending.endswith(SYNC[:1]) else 0
+                write(pending[:len(pending) - keep].decode("utf-8", "replace"))
+                pending = pending[len(pending) - keep:]
+                break
+            write(pending[:start].decode("utf-8", "replace"))
+            pending = pending[start:]
+            if len(pending) < HEADER_LEN:
+                break
+            num_args = pending[2]
+            length = HEADER_LEN + 4 * num_args
+            if len(pending) < length:
+                break
+            fmt_addr, = struct.unpack_from("<I", pending, 4)
+            args = struct.unpack_from(f"<{num_args}I", pending, HEADER_LEN)
+            write(format_record(elf, fmt_addr, args) + "\n")
+            pending = pending[length:]
+    write(pending.decode("utf-8", "replace"))
+
+
+def main(argv):
+    parser = argparse.ArgumentParser(description=__doc__.split("\n\n")[0].strip())
+    parser.add_argument("elf", help="ELF of the running firmware")
+    parser.add_argument("source", help="serial port, capture file or - for stdin")
+    parser.add_argument("--baud", type=int, default=115200)
+    args = parser.parse_args(argv)
+
+    elf = Elf(args.elf)
+
+    def write(text):
+        sys.stdout.write(text)
+        sys.stdout.flush()
+
+    if args.source == "-":
+        decode(elf, sys.stdin.buffer.read1, write)
+    elif args.source.startswith("/dev/"):
+        import serial
+
+        with serial.Serial(args.source, args.baud, rtscts=True, timeout=0.05) as port:
+            def read(n):
+                # keep waiting on an idle port, a serial stream has no end
+                while True:
+                    data = port.read(n)
+                    if data:
+                        return data
+
+            decode(elf, read, write)
+    else:
+        with open(args.source, "rb") as f:
+            decode(elf, f.read, write)
+
+
+if __name__ == "__main__":
+    try:
+        main(sys.argv[1:])
+    except KeyboardInterrupt:
+        pass
@@ -0,0 +1,119 @@
+"""
+Upload an image into the secondary slot over the bootloader's serial recovery
+protocol (common/include/serial_recovery.h).
+
+Sends "upload" to the shell, then streams the image in 256 byte chunks with
+a window of frames in flight, going back to the device's offset on a NAK or
+a timeout.
+
+    python3 serial_upload.py /dev/ttyACM0 build/application-signed.bin --baud 1000000
+"""
+import argparse
+import struct
+import sys
+import time
+import zlib
+
+SYNC = b"\xa5\x5a"
+MAX_CHUNK = 256
+DATA, END, ABORT = 1, 2, 3
+ACK, NAK, DONE, FAIL = 0, 1, 2, 3
+STATUS_NAMES = {ACK: "ACK", NAK: "NAK", DONE: "DONE", FAIL: "FAIL"}
+
+
+def frame(kind, offset, payload=b""):
+    body = struct.pack("<BBIHH", kind, 0, offset, len(payload), 0) + payload
+    return SYNC + body + struct.pack("<I", zlib.crc32(body))
+
+
+def read_response(port, timeout):
+    """Returns (status, offset) of the next response, None on timeout. Log
+    lines and shell echo around the responses are skipped."""
+    deadline = time.monotonic() + timeout
+    prev = b""
+    while time.monotonic() < deadline:
+        c = port.read(1)
+        if not c:
+            continue
+        if prev + c != SYNC:
+            prev = c
+            continue
+        body = port.read(10)
+        if len(body) != 10:
+            return None
+        status, _, offset, crc = struct.unpack("<BBII", body)
+        if zlib.crc32(body[:6]) == crc:
+            return status, offset
+        prev = b""
+    return None
+
+
+def upload(port, image, window=3, timeout=1.0, end_retries=5, log=print):
+    """Streams image to a device already running serial_recovery_receive()."""
+    size = len(image)
+    acked = 0
+    sent = 0
+    rewinds = 0
+    while acked < size:
+        while sent < size and sent - acked < window * MAX_CHUNK:
+            chunk = image[sent:sent + MAX_CHUNK]
+            port.write(frame(DATA, sent, chunk))
+            sent += len(chunk)
+
+        rsp = read_response(port, timeout)
+        if rsp is None:
+            sent = acked
+            rewinds += 1
+            continue
+        status, offset = rsp
+        if status == FAIL:
+            raise RuntimeError(f"device failed at offset {offset:#x}")
+        acked = max(acked, offset)
+        if status == NAK:
+            sent = offset
+            rewinds += 1
+
+    # a corrupted END is NAKed once, or dropped silently after that, so it is
+    # resent like a DATA frame. The wait covers erasing the rest of the slot.
+    end = frame(END, size, struct.pack("<I", zlib.crc32(image)))
+    for _ in range(end_retries):
+        port.write(end)
+        rsp = read_response(port, timeout * 10)
+        # acks for repeated frames can still be queued ahead of the result
+        while rsp is not None and rsp[0] == ACK:
+            rsp = read_response(port, timeout * 10)
+        if rsp is not None and rsp[0] in (DONE, FAIL):
+            break
+        rewinds += 1
+    else:
+        raise RuntimeError("no reply to END")
+    if rsp[0] != DONE:
+        raise RuntimeError(f"device rejected the image at {rsp[1]:#x}")
+    log(f"{size} bytes uploaded, {rewinds} resends")
+
+
+def main(argv):
+    parser = argparse.ArgumentParser(description=__doc__.split("\n\n")[0].strip())
+    parser.add_argument("port", help="serial port")
+    parser.add_argument("image", help="signed image for the secondary slot")
+    parser.add_argument("--baud", type=int, default=115200)
+    parser.add_argument("--window", type=int, default=3, help="frames in flight")
+    args = parser.parse_args(argv)
+
+    import serial
+
+    with open(args.image, "rb") as f:
+        image = f.read()
+    with serial.Serial(args.port, args.baud, rtscts=True, timeout=0.05) as port:
+        port.reset_input_buffer()
+        port.write(b"upload\n")
+        rsp = read_response(port, 2.0)
+        if rsp != (ACK, 0):
+            sys.exit(f"device did not start the upload: {rsp}")
+        start = time.monotonic()
+        upload(port, image, window=args.window)
+        print(f"{len(image) / (time.monotonic() - start) / 1024:.1f} kB/s")
+
+
+if __name__ == "__main__":
+    main(sys.argv[1:])
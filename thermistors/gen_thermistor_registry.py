@@ -0,0 +1,182 @@
+"""
+Generate thermistor_registry.hpp from datasheet resistance tables.
+
+Each CSV is a datasheet table in the layout of ntcg103jx103dt1.csv: a P/N row,
+an R25 row giving the resistance unit, then a Temp,Min,Nom,Max,... header and
+one row per degree. Steinhart-Hart is fitted to the nominal column by linear
+least squares in 1/T, the same model the notebook fits with curve_fit. The
+header holds the coefficients and one constexpr LUT per part, divider and ADC
+width, so the tables are built by the compiler and the device only
+interpolates.
+
+    python3 gen_thermistor_registry.py ntcg103jx103dt1.csv \\
+        --divider 10000 --divider 4700 --bits 10 --bits 12 -o thermistor_registry.hpp
+"""
+import argparse
+import csv
+import math
+import os
+import re
+import sys
+
+CELSIUS_TO_KELVIN = 273.15
+UNITS = {"": 1.0, "k": 1e3, "M": 1e6}
+
+
+def read_datasheet(path):
+    """Returns (part number, [(temp C, nominal ohms)]) from a datasheet CSV."""
+    part_number = None
+    mult = 1.0
+    points = []
+    header = None
+    with open(path, newline="") as f:
+        for row in csv.reader(f):
+            row = [c.strip() for c in row]
+            if not row or not row[0]:
+                continue
+            if header is None:
+                if row[0] == "P/N":
+                    part_number = row[1]
+                elif row[0] == "R25":
+                    mult = UNITS[row[2].split()[0] if row[2] else ""]
+                elif row[0] == "Temp":
+                    header = row
+                continue
+            values = dict(zip(header, row))
+            points.append((float(values["Temp"]), float(values["Nom"]) * mult))
+    if part_number is None or not points:
+        raise ValueError(f"{path}: no part number or resistance table")
+    if 25.0 not in dict(points):
+        raise ValueError(f"{path}: no 25C row for R25")
+    return part_number, points
+
+
+def solve3(m, v):
+    """Solves the 3x3 system m x = v, Gaussian elimination with pivoting."""
+    a = [list(m[i]) + [v[i]] for i in range(3)]
+    for col in range(3):
+        pivot = max(range(col, 3), key=lambda r: abs(a[r][col]))
+        a[col], a[pivot] = a[pivot], a[col]
+        for r in range(col + 1, 3):
+            k = a[r][col] / a[col][col]
+            for c in range(col, 4):
+                a[r][c] -= k * a[col][c]
+    x = [0.0] * 3
+    for r in reversed(range(3)):
+        x[r] = (a[r][3] - sum(a[r][c] * x[c] for c in range(r + 1, 3))) / a[r][r]
+    return x
+
+
+def fit_steinhart_hart(points):
+    """Least squares A, B, C for 1/T = A + B ln R + C ln^3 R."""
+    rows = []
+    for temp_c, r in points:
+        ln_r = math.log(r)
+        rows.append(([1.0, ln_r, ln_r**3], 1.0 / (temp_c + CELSIUS_TO_KELVIN)))
+    # Scale the columns to unit norm so the normal equations stay well
+    # conditioned, ln^3 R is three orders of magnitude above 1
+    scale = [math.sqrt(sum(x[j] ** 2 for x, _ in rows)) for j in range(3)]
+    ata = [[sum(x[i] * x[j] for x, _ in rows) / (scale[i] * scale[j]) for j in range(3)] for i in range(3)]
+    aty = [sum(x[i] * y for x, y in rows) / scale[i] for i in range(3)]
+    return [c / s for c, s in zip(solve3(ata, aty), scale)]
+
+
+def fit_error_k(coeffs, points):
+    a, b, c = coeffs
+    worst = 0.0
+    for temp_c, r in points:
+        ln_r = math.log(r)
+        worst = max(worst, abs(1.0 / (a + b * ln_r + c * ln_r**3) - (temp_c + CELSIUS_TO_KELVIN)))
+    return worst
+
+
+def identifier(part_number):
+    return re.sub(r"\W", "_", part_number).lower()
+
+
+def ohms_name(r):
+    if r % 1000 == 0:
+        return f"{r // 1000}k"
+    if r >= 1000:
+        return f"{r // 1000}k{r % 1000 // 100}"
+    return f"{r}r"
+
+
+def generate(parts, dividers, bits_list, size, command):
+    out = []
+    out.append(f"// Generated by gen_thermistor_registry.py, do not edit.\n// {command}\n")
+    out.append("#pragma once\n\n#include \"thermistor_lut.hpp\"\n\n")
+    out.append("namespace thermistor_registry {\n\n")
+
+    for bits in bits_list:
+        codes = 1 << bits
+        if codes % size:
+            raise ValueError(f"{size} entries do not evenly cover a {bits} bit ADC")
+        step = codes // size
+        out.append(f"inline constexpr AdcSpacing spacing_{bits}bit{{\n"
+                   f"    start: {step // 4},\n    step: {step},\n    size: {size}\n}};\n")
+    out.append("\n")
+
+    for part_number, points, coeffs in parts:
+        name = identifier(part_number)
+        err = fit_error_k(coeffs, points)
+        temps = [t for t, _ in points]
+        a, b, c = coeffs
+        r25 = dict(points)[25.0]
+        out.append(f"// {part_number}, fit over {min(temps):g}C to {max(temps):g}C\n")
+        out.append(f"inline constexpr ThermistorPart {name}{{\n"
+                   f"    part_number: \"{part_number}\",\n"
+                   f"    thermistor: {{A: {a:.9e}, B: {b:.9e}, C: {c:.9e}, R: {r25:g}}},\n"
+                   f"    t_min_c: {int(min(temps))},\n    t_max_c: {int(max(temps))},\n"
+                   f"    fit_error_k: {err:.4f}\n}};\n")
+        out.append(f"static_assert(steinhart_hart_equations({r25:g}, {name}.thermistor) > 298.15 - {name}.fit_error_k - 0.01 &&\n"
+                   f"              steinhart_hart_equations({r25:g}, {name}.thermistor) < 298.15 + {name}.fit_error_k + 0.01,\n"
+                   f"              \"{part_number} fit does not give 25C at R25\");\n\n")
+
+    entries = []
+    for part_number, _, _ in parts:
+        name = identifier(part_number)
+        for r_div in dividers:
+            for bits in bits_list:
+                lut = f"lut_{name}_{ohms_name(r_div)}_{bits}bit"
+                out.append(f"inline constexpr auto {lut} = calc_lut<{size},16>(spacing_{bits}bit, {bits}, {name}.thermistor, {r_div});\n")
+                entries.append(f"    {{{name}.part_number, {r_div}, {bits}, spacing_{bits}bit, {lut}}},\n")
+    out.append("\n")
+
+    out.append(f"inline constexpr std::array<ThermistorLut, {len(entries)}> luts{{{{\n")
+    out.extend(entries)
+    out.append("}};\n\n")
+    out.append("constexpr const ThermistorLut* find(std::string_view part_number, const uint32_t r_div, const uint32_t adc_bits) {\n"
+               "    return find_thermistor_lut(luts, part_number, r_div, adc_bits);\n}\n\n")
+    out.append("}  // namespace thermistor_registry\n")
+    return "".join(out)
+
+
+def main(argv):
+    parser = argparse.ArgumentParser(description=__doc__.split("\n\n")[0].strip())
+    parser.add_argument("csv", nargs="+", help="datasheet resistance tables")
+    parser.add_argument("--divider", type=int, action="append", help="top resistor in ohms, repeatable (default 10000)")
+    parser.add_argument("--bits", type=int, action="append", help="ADC width, repeatable (default 12)")
+    parser.add_argument("--size", type=int, default=128, help="entries per table")
+    parser.add_argument("-o", "--output", default="thermistor_registry.hpp")
+    args = parser.parse_args(argv)
+
+    parts = []
+    for path in args.csv:
+        try:
+            part_number, points = read_datasheet(path)
+        except ValueError as e:
+            sys.exit(f"error: {e}")
+        parts.append((part_number, points, fit_steinhart_hart(points)))
+
+    command = " ".join(["python3", "gen_thermistor_registry.py"] + [os.path.basename(a) if a in args.csv else a for a in argv])
+    text = generate(parts, args.divider or [10000], args.bits or [12], args.size, command)
+    with open(args.output, "w") as f:
+        f.write(text)
+    for part_number, points, coeffs in parts:
+        print(f"{part_number}: A={coeffs[0]:.6e} B={coeffs[1]:.6e} C={coeffs[2]:.6e}, "
+              f"max fit error {fit_error_k(coeffs, points):.4f} K")
+
+
+if __name__ == "__main__":
+    main(sys.argv[1:])
@@ -0,0 +1,1179 @@
+#pragma once
+
+#include <cstdint>
+#include <cmath>
+#include <cassert>
+#include <array>
+#include <bit>
+#include <algorithm>
+#include <numeric>
+#include <span>
+#include <numbers>
+#include <limits>
+#include <string_view>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#define THERMISTOR_LUT_HAS_X86_KERNELS 1
+#else
+#define THERMISTOR_LUT_HAS_X86_KERNELS 0
+#endif
+
+struct AdcSpacing {
+    uint32_t start;
+    uint32_t step;
+    uint32_t size;
+
+    constexpr uint32_t max() const {
+        return at(size-1);
+    }
+    constexpr uint32_t at(const std::size_t index) const {
+        return step*index + start;
+    }
+    constexpr bool is_pow2() const {
+        return std::has_single_bit(step);
+    }
+    // log2(step), only meaningful when is_pow2()
+    constexpr uint32_t step_shift() const {
+        return std::countr_zero(step);
+    }
+    // Segment holding offset = x - start, a shift for power of two steps
+    constexpr uint32_t index(const uint32_t offset) const {
+        return is_pow2() ? (offset >> step_shift()) : (offset / step);
+    }
+};
+
+struct Thermistor {
+    double A;
+    double B;
+    double C;
+    double R = 10000;
+};
+
+
+/*
+ * Linear interpolation between the table entries either side of x. Inputs
+ * outside the table are clamped to the first and last entries.
+ * The product is done in 64 bits so steep segments do not overflow and the
+ * slope is not truncated before it is applied.
+ */
+template <typename T, std::size_t N>
+constexpr T interpolate(const AdcSpacing& spacing, const std::array<T, N>& y_vals, const uint32_t x) {
+    static_assert(N >= 2, "x_vals and y_vals must have at least two elements");
+
+    const uint32_t xc = std::clamp<uint32_t>(x, spacing.start, spacing.at(N - 1));
+    const std::size_t i = std::min<std::size_t>((xc - spacing.start) / spacing.step, N - 2);
+
+    const uint32_t x0 = spacing.at(i);
+    const int64_t y0 = static_cast<int64_t>(y_vals.at(i));
+    const int64_t y1 = static_cast<int64_t>(y_vals.at(i + 1));
+
+    return static_cast<T>(y0 + (y1 - y0) * static_cast<int64_t>(xc - x0) / spacing.step);
+}
+
+// Same as above for a table whose length is only known at runtime
+constexpr uint32_t interpolate(const AdcSpacing& spacing, std::span<const uint32_t> y_vals, const uint32_t x) {
+    assert(y_vals.size() >= 2);
+    const std::size_t n = y_vals.size();
+    const uint32_t xc = std::clamp<uint32_t>(x, spacing.start, spacing.at(n - 1));
+    const std::size_t i = std::min<std::size_t>((xc - spacing.start) / spacing.step, n - 2);
+
+    const int64_t y0 = static_cast<int64_t>(y_vals[i]);
+    const int64_t y1 = static_cast<int64_t>(y_vals[i + 1]);
+    return static_cast<uint32_t>(y0 + (y1 - y0) * static_cast<int64_t>(xc - spacing.at(i)) / spacing.step);
+}
+
+
+/*
+ * Natural logarithm that can be evaluated in a constant expression. std::log
+ * is only constexpr as a compiler extension, so LUTs built with it are not
+ * portable.
+ *
+ * fdlibm's __ieee754_log on the bit pattern: x = (1 + f) * 2^k with 1 + f in
+ * [sqrt(2)/2, sqrt(2)), s = f/(2 + f) and log(1 + f) = f - f^2/2 + s(f^2/2 + R)
+ * with R a degree 14 minimax polynomial in s. Keeping f^2/2 out of the
+ * polynomial and ln2 split in two (the low half of ln2_hi is zero, so k*ln2_hi
+ * is exact) holds the error below 1 ulp, where a truncated atanh series
+ * summed as a whole reached 3 ulp. thermistor_lut_test.cpp sweeps it against
+ * std::log.
+ */
+constexpr double constexpr_log(double x) {
+    constexpr double ln2_hi = 6.93147180369123816490e-01;  // 3fe62e42 fee00000
+    constexpr double ln2_lo = 1.90821492927058770002e-10;  // 3dea39ef 35793c76
+    constexpr double Lg1 = 6.666666666666735130e-01;  // 3fe55555 55555593
+    constexpr double Lg2 = 3.999999999940941908e-01;  // 3fd99999 9997fa04
+    constexpr double Lg3 = 2.857142874366239149e-01;  // 3fd24924 94229359
+    constexpr double Lg4 = 2.222219843214978396e-01;  // 3fcc71c5 1d8e78af
+    constexpr double Lg5 = 1.818357216161805012e-01;  // 3fc74664 96cb03de
+    constexpr double Lg6 = 1.531383769920937332e-01;  // 3fc39a09 d078c69f
+    constexpr double Lg7 = 1.479819860511658591e-01;  // 3fc2f112 df3e5244
+
+    if (x != x || x < 0) {
+        return std::numeric_limits<double>::quiet_NaN();
+    }
+    if (x == 0) {
+        return -std::numeric_limits<double>::infinity();
+    }
+    if (x == std::numeric_limits<double>::infinity()) {
+        return x;
+    }
+
+    int k = 0;
+    uint64_t bits = std::bit_cast<uint64_t>(x);
+    if ((bits >> 52) == 0) {
+        // subnormal, scale into the normal range
+        x *= 18014398509481984.0;  // 2^54
+        k -= 54;
+        bits = std::bit_cast<uint64_t>(x);
+    }
+    int32_t hx = static_cast<int32_t>(bits >> 32);
+    k += (hx >> 20) - 1023;
+    hx &= 0x000fffff;
+    // 0x95f64 is where the mantissa passes sqrt(2), halve x from there on
+    const int32_t i = (hx + 0x95f64) & 0x100000;
+    x = std::bit_cast<double>((static_cast<uint64_t>(hx | (i ^ 0x3ff00000)) << 32) | (bits & 0xffffffffull));
+    k += i >> 20;
+    const double f = x - 1.0;
+    const double dk = k;
+
+    if ((0x000fffff & (2 + hx)) < 3) {
+        // |f| < 2^-20, two terms of the series are enough
+        if (f == 0) {
+            return dk*ln2_hi + dk*ln2_lo;
+        }
+        const double R = f*f*(0.5 - 0.33333333333333333*f);
+        return dk*ln2_hi - ((R - dk*ln2_lo) - f);
+    }
+
+    const double s = f/(2.0 + f);
+    const double z = s*s;
+    const double w = z*z;
+    const double t1 = w*(Lg2 + w*(Lg4 + w*Lg6));
+    const double t2 = z*(Lg1 + w*(Lg3 + w*(Lg5 + w*Lg7)));
+    const double R = t2 + t1;
+    if (((hx - 0x6147a) | (0x6b851 - hx)) > 0) {
+        // f^2/2 carried separately, f is far enough from 0
+        const double hfsq = 0.5*f*f;
+        return dk*ln2_hi - ((hfsq - (s*(hfsq + R) + dk*ln2_lo)) - f);
+    }
+    return dk*ln2_hi - ((s*(f - R) - dk*ln2_lo) - f);
+}
+
+/*
+ * Compile time accuracy check of constexpr_log against values of log(x)
+ * rounded to double, over the range thermistor resistances use and beyond.
+ */
+constexpr bool constexpr_log_accurate(const double max_ulp = 1) {
+    struct Reference {
+        double x;
+        double log_x;
+    };
+    constexpr Reference refs[] = {
+        {1.0, 0.0},
+        {2.0, std::numbers::ln2},
+        {10.0, std::numbers::ln10},
+        {std::numbers::e, 1.0},
+        {std::numbers::pi, 1.1447298858494002},
+        {0.5, -std::numbers::ln2},
+        {0.1, -2.3025850929940455},
+        {1.5, 0.4054651081081644},
+        {1.4142, 0.34656400018800332},
+        {100.0, 4.605170185988092},
+        {10e3, 9.210340371976184},
+        {123456.789, 11.723646487185881},
+        {1e6, 13.815510557964274},
+        {1e-300, -690.7755278982137},
+    };
+    for (const auto& ref : refs) {
+        const double err = constexpr_log(ref.x) - ref.log_x;
+        const double mag = ref.log_x < 0 ? -ref.log_x : ref.log_x;
+        // One ulp of the reference, 2^exponent(mag) * epsilon
+        double ulp = 0;
+        if (mag != 0) {
+            ulp = std::numeric_limits<double>::epsilon();
+            while (ulp * 2 <= mag * std::numeric_limits<double>::epsilon()) {
+                ulp *= 2;
+            }
+            while (ulp > mag * std::numeric_limits<double>::epsilon()) {
+                ulp /= 2;
+            }
+        }
+        if (err > max_ulp*ulp || err < -max_ulp*ulp) {
+            return false;
+        }
+    }
+    return true;
+}
+static_assert(constexpr_log_accurate(), "constexpr_log is not within 1 ulp of log");
+
+template<typename type_t=double>
+constexpr type_t steinhart_hart_equations(const type_t R, const type_t A, const type_t B, const type_t C) {
+    const type_t logr = constexpr_log(R);
+    const auto inv_t = A + B*logr + C*logr*logr*logr;
+    return 1/inv_t;
+}
+
+constexpr double steinhart_hart_equations(const double r, const Thermistor& thermistor) {
+    return steinhart_hart_equations<double>(r, thermistor.A, thermistor.B, thermistor.C);
+}
+
+/*
+ * Temperature in Kelvin for an ADC code, thermistor on the low side of a
+ * divider with an r_div top resistor, clamped to 100K-1000K.
+ */
+constexpr double adc_to_kelvin(const uint32_t adc, const std::size_t bits, const Thermistor& thermistor,
+                               const double r_div = 10e3) {
+    const double adc_max = (1<<bits) - 1;
+    const double tmax = 1e3;
+    const double tmin = 100;
+
+    if (adc >= adc_max) {
+        // the rail reads as an open thermistor, colder than the clamp; a
+        // table with an entry per code has one here
+        return tmin;
+    }
+    const double voltage_ratio = static_cast<double>(adc)/adc_max;
+
+    const double resistance = voltage_ratio*r_div/(1-voltage_ratio);
+    return std::clamp(steinhart_hart_equations(resistance, thermistor), tmin, tmax);
+}
+
+/*
+ * Generate a list of temperature readings
+ */
+template<unsigned int kLutSize, unsigned int kShift=16, typename T=uint32_t>
+constexpr std::array<T, kLutSize> calc_lut(const AdcSpacing& spacing, const std::size_t bits, const Thermistor& thermistor,
+                                           const double r_div = 10e3) {
+    std::array<T, kLutSize> arr{};
+    const double mult = 1<<kShift;
+
+    for (std::size_t i = 0; i < arr.size(); ++i) {
+        arr[i] = static_cast<T>(adc_to_kelvin(spacing.at(i), bits, thermistor, r_div) * mult);
+    }
+
+    return arr;
+}
+
+/*
+ * Output formats for tables. Each maps a temperature in Kelvin to the table's
+ * value type, saturating at the ends of the type. The 16 bit formats halve
+ * the table against Q16.16 and cover the usual NTC range, Q8.8 Celsius to
+ * +-128C and centi-degrees to +-327C.
+ */
+struct KelvinQ16 {
+    using type = uint32_t;
+    static constexpr const char* name = "K Q16.16";
+    // Truncates like calc_lut<N, 16>, so the tables match
+    static constexpr type from_kelvin(const double k) {
+        return static_cast<type>(k * 65536.0);
+    }
+    static constexpr double to_kelvin(const type y) {
+        return y / 65536.0;
+    }
+};
+
+template<int kScale, typename T=int16_t>
+constexpr T saturate_celsius(const double k) {
+    const double v = (k - 273.15) * kScale;
+    const double r = v < 0 ? v - 0.5 : v + 0.5;
+    return static_cast<T>(std::clamp<double>(r, std::numeric_limits<T>::min(), std::numeric_limits<T>::max()));
+}
+
+struct CelsiusQ8_8 {
+    using type = int16_t;
+    static constexpr const char* name = "C Q8.8";
+    static constexpr type from_kelvin(const double k) {
+        return saturate_celsius<256>(k);
+    }
+    static constexpr double to_kelvin(const type y) {
+        return y / 256.0 + 273.15;
+    }
+};
+
+struct CentiCelsius {
+    using type = int16_t;
+    static constexpr const char* name = "C x100";
+    static constexpr type from_kelvin(const double k) {
+        return saturate_celsius<100>(k);
+    }
+    static constexpr double to_kelvin(const type y) {
+        return y / 100.0 + 273.15;
+    }
+};
+
+/*
+ * Uniform table for a kBits ADC with kSize entries in Format. The step is a
+ * power of two and the first entry sits a quarter step in, the layout the
+ * 12 bit example uses, so every combination is a compile time constant:
+ *
+ *   constexpr auto table = make_thermistor_table<10, 64, CentiCelsius>(thermistor);
+ *   int16_t centi_c = table(adc);
+ */
+template<unsigned int kBits, std::size_t kSize=128, typename Format=KelvinQ16>
+struct ThermistorTable {
+    static_assert(kBits >= 10 && kBits <= 16, "10 to 16 bit ADCs");
+    static_assert(std::has_single_bit(kSize) && kSize >= 2 && kSize <= (std::size_t{1} << kBits),
+                  "table size must be a power of two no larger than the code range");
+    using format = Format;
+    using value_type = typename Format::type;
+
+    static constexpr uint32_t kStep = static_cast<uint32_t>((std::size_t{1} << kBits) / kSize);
+    static constexpr AdcSpacing spacing{kStep / 4, kStep, static_cast<uint32_t>(kSize)};
+
+    std::array<value_type, kSize> y{};
+
+    constexpr value_type operator()(const uint32_t adc) const {
+        return interpolate(spacing, y, adc);
+    }
+
+    // temps must be at least as long as adc
+    void convert(std::span<const uint32_t> adc, std::span<value_type> temps) const {
+        assert(temps.size() >= adc.size());
+        for (std::size_t i = 0; i < adc.size(); ++i) {
+            temps[i] = (*this)(adc[i]);
+        }
+    }
+
+    static constexpr std::size_t bytes() {
+        return sizeof(y);
+    }
+};
+
+template<unsigned int kBits, std::size_t kSize=128, typename Format=KelvinQ16>
+constexpr ThermistorTable<kBits, kSize, Format> make_thermistor_table(const Thermistor& thermistor, const double r_div = 10e3) {
+    using Table = ThermistorTable<kBits, kSize, Format>;
+    Table table{};
+    for (std::size_t i = 0; i < kSize; ++i) {
+        table.y[i] = Format::from_kelvin(adc_to_kelvin(Table::spacing.at(i), kBits, thermistor, r_div));
+    }
+    return table;
+}
+
+/*
+ * Companion slope table for calc_lut: slopes[i] is the change in y per ADC
+ * code between entries i and i + 1, with kSlopeShift fractional bits. The last
+ * entry is unused and zero. Q16.16 Kelvin tables over a 12 bit ADC have
+ * deltas up to 2^26 per segment, which leaves room for 8 fractional bits.
+ */
+template<unsigned int kSlopeShift=8, typename T, std::size_t N>
+constexpr std::array<int32_t, N> calc_slopes(const AdcSpacing& spacing, const std::array<T, N>& y_vals) {
+    static_assert(N >= 2, "need at least two entries for a slope");
+    std::array<int32_t, N> slopes{};
+    for (std::size_t i = 0; i + 1 < N; ++i) {
+        const int64_t dy = (static_cast<int64_t>(y_vals[i + 1]) - static_cast<int64_t>(y_vals[i])) * (int64_t{1} << kSlopeShift);
+        const int64_t half = static_cast<int64_t>(spacing.step / 2);
+        // round to nearest, away from zero on ties
+        const int64_t slope = (dy + (dy < 0 ? -half : half)) / static_cast<int64_t>(spacing.step);
+        // Fails constant evaluation when kSlopeShift is too large for the curve
+        assert(slope >= INT32_MIN && slope <= INT32_MAX);
+        slopes[i] = static_cast<int32_t>(slope);
+    }
+    return slopes;
+}
+
+/*
+ * Interpolation with a precomputed slope table, no divides when the spacing
+ * step is a power of two: the index is a shift and the interpolation is one
+ * multiply-add. The rounded slopes and the flooring shift keep the result
+ * within one LSB of interpolate().
+ */
+template <unsigned int kSlopeShift=8, typename T, std::size_t N>
+constexpr T interpolate_sloped(const AdcSpacing& spacing, const std::array<T, N>& y_vals,
+                               const std::array<int32_t, N>& slopes, const T& x) {
+    const uint32_t xc = std::clamp<uint32_t>(x, spacing.start, spacing.at(N - 1));
+    const uint32_t offset = xc - spacing.start;
+    const uint32_t i = std::min<uint32_t>(spacing.index(offset), N - 2);
+    // i*step is a shift for power of two steps, not a mask: the last entry
+    // sits at the end of segment N - 2
+    const int64_t frac = offset - i*spacing.step;
+    return static_cast<T>(static_cast<int64_t>(y_vals[i]) + ((slopes[i] * frac) >> kSlopeShift));
+}
+
+/*
+ * Inverse table, Q16.16 Kelvin to ADC code, for comparing against setpoints
+ * in ADC counts instead of converting every sample.
+ *
+ * For a decreasing (NTC on the low side) forward table, threshold(t) is the
+ * smallest code whose interpolated temperature is at or below t, or 2^bits
+ * when there is none. For every code x,
+ *
+ *   interpolate(spacing, lut, x) > t  exactly when  x < threshold(t)
+ *
+ * The table holds the threshold at N temperatures 2^shift apart. A lookup
+ * takes the two entries either side of t and bisects the codes between them
+ * against the forward table, so the result matches the forward conversion
+ * code for code. Temperatures outside the table search up to the ends of the
+ * code range.
+ */
+template<std::size_t N, std::size_t kForward>
+struct InverseLut {
+    static_assert(N >= 2, "need at least two entries");
+
+    AdcSpacing spacing{};
+    uint32_t code_limit = 0;
+    uint32_t t_first = 0;
+    uint32_t t_shift = 0;
+    // Up to code_limit, 2^16 for a 16 bit ADC
+    std::array<uint32_t, N> codes{};
+
+    // Smallest code in [lo, hi] converting to t or below, hi must satisfy it
+    constexpr uint32_t search(const std::array<uint32_t, kForward>& forward, const uint32_t t, uint32_t lo, uint32_t hi) const {
+        while (lo < hi) {
+            const uint32_t mid = lo + (hi - lo) / 2;
+            if (mid >= code_limit || interpolate<uint32_t>(spacing, forward, mid) <= t) {
+                hi = mid;
+            } else {
+                lo = mid + 1;
+            }
+        }
+        return lo;
+    }
+
+    constexpr uint32_t threshold(const std::array<uint32_t, kForward>& forward, const uint32_t t) const {
+        if (t < t_first) {
+            return search(forward, t, codes[0], code_limit);
+        }
+        const std::size_t j = std::min<std::size_t>((t - t_first) >> t_shift, N - 1);
+        return search(forward, t, j + 1 < N ? codes[j + 1] : 0, codes[j]);
+    }
+};
+
+/*
+ * Inverse of a forward table over temperatures t_first to t_last (Q16.16
+ * Kelvin), with the smallest power of two spacing that covers the range in N
+ * entries.
+ */
+template<std::size_t N, std::size_t kForward>
+constexpr InverseLut<N, kForward> calc_inverse_lut(const AdcSpacing& spacing, const std::array<uint32_t, kForward>& forward,
+                                                   const std::size_t bits, const uint32_t t_first, const uint32_t t_last) {
+    for (std::size_t i = 0; i + 1 < kForward; ++i) {
+        // Fails constant evaluation for a table that is not decreasing
+        assert(forward[i + 1] <= forward[i]);
+    }
+    assert(t_first < t_last);
+
+    InverseLut<N, kForward> inv{};
+    inv.spacing = spacing;
+    inv.code_limit = uint32_t{1} << bits;
+    inv.t_first = t_first;
+    while ((static_cast<uint64_t>(N - 1) << inv.t_shift) < t_last - t_first) {
+        inv.t_shift++;
+    }
+    for (std::size_t j = 0; j < N; ++j) {
+        const uint64_t t = t_first + (static_cast<uint64_t>(j) << inv.t_shift);
+        const uint32_t tc = static_cast<uint32_t>(std::min<uint64_t>(t, UINT32_MAX));
+        inv.codes[j] = inv.search(forward, tc, 0, inv.code_limit);
+    }
+    return inv;
+}
+
+// Q16.16 Kelvin for a temperature in Celsius, for setpoint constants
+constexpr uint32_t celsius_to_kelvin_q16(const double celsius) {
+    return static_cast<uint32_t>((celsius + 273.15) * 65536.0 + 0.5);
+}
+
+
+/*
+ * Streaming decimator for oversampled ADC channels.
+ *
+ * Raw codes are summed in blocks of kDecimation (a moving average that is
+ * dumped once per block, a first order CIC) and each full block gives one
+ * output code with kFracBits fraction bits, the resolution the oversampling
+ * adds. With kRejectExtremes the smallest and largest code of each block are
+ * dropped before averaging, so a single spike or dropout in a block does not
+ * reach the output. Integer only: one compare pair and an add per raw sample,
+ * one divide per output.
+ *
+ * Output codes convert with a table built for the raw codes by scaling the
+ * spacing, see oversampled().
+ */
+template<unsigned int kDecimation, unsigned int kFracBits=2, bool kRejectExtremes=true>
+class AdcDecimator {
+    static constexpr uint32_t kKept = kDecimation - (kRejectExtremes ? 2 : 0);
+    static_assert(kKept >= 1, "a block must keep at least one sample");
+
+public:
+    static constexpr unsigned int frac_bits = kFracBits;
+
+    // Spacing for looking up output codes in a table built on spacing
+    static constexpr AdcSpacing oversampled(const AdcSpacing& spacing) {
+        return {spacing.start << kFracBits, spacing.step << kFracBits, spacing.size};
+    }
+
+    /*
+     * Feeds raw codes, calling emit(code) with each output code. A partial
+     * block carries over to the next call. Returns the number of outputs.
+     */
+    template<typename Emit>
+    constexpr std::size_t push(std::span<const uint32_t> raw, Emit&& emit) {
+        std::size_t outputs = 0;
+        for (const uint32_t x : raw) {
+            sum_ += x;
+            min_ = std::min(min_, x);
+            max_ = std::max(max_, x);
+            if (++count_ == kDecimation) {
+                emit(output());
+                outputs++;
+                reset();
+            }
+        }
+        return outputs;
+    }
+
+    constexpr void reset() {
+        sum_ = 0;
+        min_ = UINT32_MAX;
+        max_ = 0;
+        count_ = 0;
+    }
+
+private:
+    constexpr uint32_t output() const {
+        const uint64_t kept = kRejectExtremes ? sum_ - min_ - max_ : sum_;
+        return static_cast<uint32_t>(((kept << kFracBits) + kKept / 2) / kKept);
+    }
+
+    uint64_t sum_ = 0;
+    uint32_t min_ = UINT32_MAX;
+    uint32_t max_ = 0;
+    uint32_t count_ = 0;
+};
+
+
+/*
+ * Registry of prebuilt tables, see gen_thermistor_registry.py.
+ *
+ * A part is a Steinhart-Hart fit to a datasheet resistance table. A table is
+ * keyed by the part, the divider's top resistor and the ADC width, all fixed
+ * by the board, so picking the table for a channel is a lookup and the device
+ * never fits or evaluates the curve.
+ */
+struct ThermistorPart {
+    std::string_view part_number;
+    Thermistor thermistor;
+    // Datasheet range the fit covers, Celsius
+    int t_min_c;
+    int t_max_c;
+    // Worst fit error against the datasheet's nominal resistances, Kelvin
+    double fit_error_k;
+};
+
+struct ThermistorLut {
+    std::string_view part_number;
+    uint32_t r_div;
+    uint32_t adc_bits;
+    AdcSpacing spacing;
+    // Q16.16 Kelvin
+    std::span<const uint32_t> lut;
+
+    constexpr uint32_t operator()(const uint32_t adc) const {
+        return interpolate(spacing, lut, adc);
+    }
+};
+
+// Null when the registry has no table for the configuration
+constexpr const ThermistorLut* find_thermistor_lut(std::span<const ThermistorLut> registry, std::string_view part_number,
+                                                   const uint32_t r_div, const uint32_t adc_bits) {
+    for (const auto& entry : registry) {
+        if (entry.part_number == part_number && entry.r_div == r_div && entry.adc_bits == adc_bits) {
+            return &entry;
+        }
+    }
+    return nullptr;
+}
+
+template<unsigned int kLutSize>
+constexpr std::array<uint32_t, kLutSize> linespace(const unsigned start, const unsigned stop) {
+    static_assert(kLutSize > 0, "kLutSize must be greater than 0");
+    std::array<uint32_t, kLutSize> result = {};
+
+    if constexpr (kLutSize == 1) {
+        result[0] = start;
+        return result;
+    }
+
+    const double step = static_cast<double>(stop - start) / (kLutSize - 1);
+
+    for (unsigned int i = 0; i < kLutSize; ++i) {
+        result[i] = static_cast<uint32_t>(start + step * i + 0.5);  // round to nearest
+    }
+
+    return result;
+}
+
+
+/*
+ * Non-uniform tables.
+ *
+ * Breakpoints are placed where the curve needs them instead of every step
+ * codes. Starting from the first code, each segment is grown as far as it can
+ * go while the interpolated Q16.16 result stays within max_error_k of the
+ * Steinhart-Hart temperature at every code it covers. The check uses the same
+ * fixed point slope and shift as the lookup, so the bound holds for the table
+ * that is actually used. Greedy placement gives the fewest breakpoints for a
+ * monotonic curve like this one.
+ *
+ * Tables are built in two steps so their size is known at compile time:
+ *
+ *   constexpr auto bp = place_breakpoints<12>(first, last, thermistor, 0.05);
+ *   constexpr auto table = make_nonuniform_lut<bp.size>(bp);
+ */
+template<std::size_t kMaxEntries, unsigned int kSlopeShift=8>
+struct Breakpoints {
+    std::array<uint32_t, kMaxEntries> x{};
+    std::array<uint32_t, kMaxEntries> y{};
+    std::array<int32_t, kMaxEntries> slope{};
+    std::size_t size = 0;
+};
+
+template<unsigned int kSlopeShift=8>
+constexpr int64_t segment_slope(const int64_t y0, const int64_t y1, const uint32_t dx) {
+    const int64_t dy = (y1 - y0) * (int64_t{1} << kSlopeShift);
+    const int64_t half = static_cast<int64_t>(dx / 2);
+    return (dy + (dy < 0 ? -half : half)) / static_cast<int64_t>(dx);
+}
+
+template<unsigned int kBits, std::size_t kMaxEntries=256, unsigned int kSlopeShift=8>
+constexpr Breakpoints<kMaxEntries, kSlopeShift> place_breakpoints(
+        const uint32_t first, const uint32_t last, const Thermistor& thermistor, const double max_error_k) {
+    constexpr std::size_t kCodes = std::size_t{1} << kBits;
+    constexpr double mult = 1 << 16;
+    assert(first < last && last < kCodes);
+
+    std::array<double, kCodes> kelvin{};
+    std::array<int64_t, kCodes> q16{};
+    for (uint32_t x = first; x <= last; ++x) {
+        kelvin[x] = adc_to_kelvin(x, kBits, thermistor);
+        q16[x] = static_cast<int64_t>(kelvin[x] * mult);
+    }
+
+    const auto fits = [&](const uint32_t a, const uint32_t b) {
+        const int64_t slope = segment_slope<kSlopeShift>(q16[a], q16[b], b - a);
+        if (slope < INT32_MIN || slope > INT32_MAX) {
+            return false;
+        }
+        for (uint32_t x = a; x <= b; ++x) {
+            const int64_t y = q16[a] + ((slope * (x - a)) >> kSlopeShift);
+            const double err = static_cast<double>(y) / mult - kelvin[x];
+            if (err > max_error_k || err < -max_error_k) {
+                return false;
+            }
+        }
+        return true;
+    };
+
+    Breakpoints<kMaxEntries, kSlopeShift> bp{};
+    uint32_t a = first;
+    bp.x[0] = a;
+    bp.y[0] = static_cast<uint32_t>(q16[a]);
+    bp.size = 1;
+    while (a < last) {
+        // Gallop to bracket the longest segment, then bisect
+        uint32_t good = a + 1;
+        uint32_t step = 1;
+        while (good + step <= last && fits(a, good + step)) {
+            good += step;
+            step *= 2;
+        }
+        uint32_t bad = std::min<uint32_t>(good + step, last + 1);
+        while (bad - good > 1) {
+            const uint32_t mid = good + (bad - good) / 2;
+            if (fits(a, mid)) {
+                good = mid;
+            } else {
+                bad = mid;
+            }
+        }
+        // Fails constant evaluation when kMaxEntries is too small
+        assert(bp.size < kMaxEntries);
+        bp.slope[bp.size - 1] = static_cast<int32_t>(segment_slope<kSlopeShift>(q16[a], q16[good], good - a));
+        bp.x[bp.size] = good;
+        bp.y[bp.size] = static_cast<uint32_t>(q16[good]);
+        bp.size++;
+        a = good;
+    }
+    return bp;
+}
+
+/*
+ * Compact non-uniform table with N breakpoints.
+ *
+ * The ADC range is split into 2^kCoarseBits buckets of at most 64 codes.
+ * Each bucket holds the segment its first code lands in and a bit per code
+ * marking where a later segment starts, so the segment for a code is the
+ * bucket's base plus a popcount of the marks up to it: no search and no data
+ * dependent branches, however closely the breakpoints crowd the steep ends of
+ * the curve (down to one code apart). kCoarseBits = 0 drops the index and
+ * binary searches the whole table instead.
+ */
+template<std::size_t N, unsigned int kSlopeShift=8, unsigned int kCoarseBits=6>
+struct NonUniformLut {
+    static_assert(N >= 2, "need at least two breakpoints");
+    static_assert(N <= 256, "coarse index entries are one byte");
+    static constexpr std::size_t kBuckets = kCoarseBits ? std::size_t{1} << kCoarseBits : 0;
+
+    std::array<uint16_t, N> x{};
+    std::array<uint32_t, N> y{};
+    std::array<int32_t, N> slope{};
+    std::array<uint8_t, kBuckets> coarse{};
+    std::array<uint64_t, kBuckets> starts{};
+    uint32_t coarse_shift = 0;
+
+    // Last segment in [first, last] with x[i] <= adc
+    constexpr std::size_t search(const uint32_t adc, const std::size_t first, const std::size_t last) const {
+        std::size_t base = first;
+        std::size_t n = last - first + 1;
+        while (n > 1) {
+            const std::size_t half = n / 2;
+            base = (x[base + half] <= adc) ? base + half : base;
+            n -= half;
+        }
+        return base;
+    }
+
+    constexpr std::size_t segment(const uint32_t adc) const {
+        if constexpr (kCoarseBits == 0) {
+            return search(adc, 0, N - 2);
+        } else {
+            const uint32_t offset = adc - x[0];
+            const uint32_t bucket = offset >> coarse_shift;
+            // marks at or below offset, the shift drops those above it
+            const uint32_t bit = offset & ((uint32_t{1} << coarse_shift) - 1);
+            return coarse[bucket] + std::popcount(starts[bucket] << (63 - bit));
+        }
+    }
+
+    constexpr uint32_t operator()(const uint32_t adc) const {
+        const uint32_t xc = std::clamp<uint32_t>(adc, x[0], x[N - 1]);
+        const std::size_t i = segment(xc);
+        const int64_t frac = xc - x[i];
+        return static_cast<uint32_t>(static_cast<int64_t>(y[i]) + ((slope[i] * frac) >> kSlopeShift));
+    }
+
+    static constexpr std::size_t bytes() {
+        return N * (sizeof(uint16_t) + sizeof(uint32_t) + sizeof(int32_t)) + kBuckets * (1 + sizeof(uint64_t));
+    }
+};
+
+template<std::size_t N, unsigned int kCoarseBits=6, std::size_t kMaxEntries, unsigned int kSlopeShift>
+constexpr NonUniformLut<N, kSlopeShift, kCoarseBits> make_nonuniform_lut(const Breakpoints<kMaxEntries, kSlopeShift>& bp) {
+    assert(bp.size == N);
+    NonUniformLut<N, kSlopeShift, kCoarseBits> lut{};
+    for (std::size_t i = 0; i < N; ++i) {
+        assert(bp.x[i] <= UINT16_MAX);
+        lut.x[i] = static_cast<uint16_t>(bp.x[i]);
+        lut.y[i] = bp.y[i];
+        lut.slope[i] = bp.slope[i];
+    }
+    if constexpr (kCoarseBits != 0) {
+        // Smallest shift that maps the whole range into the buckets, fails
+        // constant evaluation when a bucket would need more than 64 marks
+        const uint32_t range = bp.x[N - 1] - bp.x[0];
+        while ((range >> lut.coarse_shift) >= lut.kBuckets) {
+            lut.coarse_shift++;
+        }
+        assert(lut.coarse_shift <= 6);
+        for (std::size_t b = 0; b < lut.kBuckets; ++b) {
+            const uint64_t code = bp.x[0] + (static_cast<uint64_t>(b) << lut.coarse_shift);
+            const uint32_t adc = static_cast<uint32_t>(std::min<uint64_t>(code, bp.x[N - 1]));
+            lut.coarse[b] = static_cast<uint8_t>(lut.search(adc, 0, N - 2));
+        }
+        // The last breakpoint ends segment N - 2 rather than starting one
+        for (std::size_t i = 1; i + 1 < N; ++i) {
+            const uint32_t offset = bp.x[i] - bp.x[0];
+            const uint32_t bit = offset & ((uint32_t{1} << lut.coarse_shift) - 1);
+            // a breakpoint on a bucket's first code is already in its base
+            if (bit != 0) {
+                lut.starts[offset >> lut.coarse_shift] |= uint64_t{1} << bit;
+            }
+        }
+    }
+    return lut;
+}
+
+/*
+ * Piecewise polynomial conversion, for channels where table memory matters
+ * more than a few multiplies.
+ *
+ * [first, last] is split into kSegments segments of 2^shift codes, so the
+ * segment is a shift of the offset. Each segment holds a degree kDegree
+ * polynomial in t = (code - segment start) / 2^shift, with Q16.16 Kelvin
+ * coefficients, evaluated by Horner's scheme in 64 bit integer arithmetic
+ * with t in Q0.16.
+ *
+ * The coefficients are fitted at compile time against adc_to_kelvin at every
+ * code of the segment: a least squares fit, then Lawson's reweighting, which
+ * moves the weights onto the worst codes and converges toward the minimax
+ * polynomial. max_error_k is the worst error of the rounded fixed point
+ * polynomial, measured the same way the lookup computes it.
+ */
+template<std::size_t kSegments, unsigned int kDegree=3>
+struct PolynomialLut {
+    static_assert(std::has_single_bit(kSegments), "segment count must be a power of two");
+    static_assert(kDegree >= 1 && kDegree <= 5, "degree 1 to 5");
+    static constexpr unsigned int kFracBits = 16;
+
+    uint32_t first = 0;
+    uint32_t last = 0;
+    uint32_t shift = 0;
+    // coeffs[s][k] multiplies t^k
+    std::array<std::array<int32_t, kDegree + 1>, kSegments> coeffs{};
+    double max_error_k = 0;
+
+    constexpr uint32_t operator()(const uint32_t adc) const {
+        const uint32_t offset = std::clamp<uint32_t>(adc, first, last) - first;
+        const auto& c = coeffs[offset >> shift];
+        const int64_t t = static_cast<int64_t>(offset & ((uint32_t{1} << shift) - 1)) << (kFracBits - shift);
+        int64_t y = c[kDegree];
+        for (unsigned int k = kDegree; k > 0; --k) {
+            y = c[k - 1] + ((y * t) >> kFracBits);
+        }
+        return static_cast<uint32_t>(y);
+    }
+
+    static constexpr std::size_t bytes() {
+        return sizeof(coeffs) + 3*sizeof(uint32_t);
+    }
+};
+
+/*
+ * Degree kDegree polynomial in t = u / seg_len through y[0..n), coefficients
+ * lowest order first. Plain arrays keep the constant evaluation cost down.
+ */
+template<unsigned int kDegree, unsigned int kLawsonIterations, std::size_t kMaxCodes>
+constexpr std::array<double, kDegree + 1> fit_segment(const double* y, const uint32_t n, const uint32_t seg_len) {
+    constexpr std::size_t kTerms = kDegree + 1;
+    double weight[kMaxCodes]{};
+    double t[kMaxCodes]{};
+    for (uint32_t u = 0; u < n; ++u) {
+        weight[u] = 1.0 / n;
+        t[u] = static_cast<double>(u) / seg_len;
+    }
+
+    double fit[kTerms]{};
+    for (unsigned int iteration = 0; iteration <= kLawsonIterations; ++iteration) {
+        // Weighted normal equations, a[i][j] only depends on i + j so
+        // accumulate the moments and fill the matrix from them
+        double moments[2*kDegree + 1]{};
+        double a[kTerms][kTerms + 1]{};
+        for (uint32_t u = 0; u < n; ++u) {
+            double p = weight[u];
+            for (std::size_t k = 0; k < kTerms; ++k) {
+                moments[k] += p;
+                a[k][kTerms] += p*y[u];
+                p *= t[u];
+            }
+            for (std::size_t k = kTerms; k < 2*kDegree + 1; ++k) {
+                moments[k] += p;
+                p *= t[u];
+            }
+        }
+        for (std::size_t i = 0; i < kTerms; ++i) {
+            for (std::size_t j = 0; j < kTerms; ++j) {
+                a[i][j] = moments[i + j];
+            }
+        }
+
+        // Elimination with partial pivoting
+        for (std::size_t col = 0; col < kTerms; ++col) {
+            std::size_t pivot = col;
+            for (std::size_t r = col + 1; r < kTerms; ++r) {
+                if ((a[r][col] < 0 ? -a[r][col] : a[r][col]) > (a[pivot][col] < 0 ? -a[pivot][col] : a[pivot][col])) {
+                    pivot = r;
+                }
+            }
+            for (std::size_t c = 0; c <= kTerms; ++c) {
+                std::swap(a[col][c], a[pivot][c]);
+            }
+            for (std::size_t r = col + 1; r < kTerms; ++r) {
+                const double f = a[r][col] / a[col][col];
+                for (std::size_t c = col; c <= kTerms; ++c) {
+                    a[r][c] -= f*a[col][c];
+                }
+            }
+        }
+        for (std::size_t r = kTerms; r-- > 0;) {
+            double v = a[r][kTerms];
+            for (std::size_t c = r + 1; c < kTerms; ++c) {
+                v -= a[r][c]*fit[c];
+            }
+            fit[r] = v / a[r][r];
+        }
+        if (iteration == kLawsonIterations) {
+            break;
+        }
+
+        // Lawson step, weight each code by its share of the error
+        double total = 0;
+        for (uint32_t u = 0; u < n; ++u) {
+            double p = fit[kDegree];
+            for (std::size_t k = kDegree; k > 0; --k) {
+                p = fit[k - 1] + p*t[u];
+            }
+            const double err = p - y[u];
+            weight[u] *= err < 0 ? -err : err;
+            total += weight[u];
+        }
+        if (total == 0) {
+            break;
+        }
+        for (uint32_t u = 0; u < n; ++u) {
+            weight[u] /= total;
+        }
+    }
+
+    std::array<double, kTerms> result{};
+    for (std::size_t k = 0; k < kTerms; ++k) {
+        result[k] = fit[k];
+    }
+    return result;
+}
+
+template<unsigned int kBits, std::size_t kSegments, unsigned int kDegree=3, unsigned int kLawsonIterations=8>
+constexpr PolynomialLut<kSegments, kDegree> fit_polynomial_lut(
+        const uint32_t first, const uint32_t last, const Thermistor& thermistor, const double r_div = 10e3) {
+    using Lut = PolynomialLut<kSegments, kDegree>;
+    constexpr std::size_t kCodes = std::size_t{1} << kBits;
+    constexpr double mult = 1 << Lut::kFracBits;
+    assert(first < last && last < kCodes);
+
+    Lut lut{};
+    lut.first = first;
+    lut.last = last;
+    while ((std::size_t{kSegments} << lut.shift) <= last - first) {
+        lut.shift++;
+    }
+    // t carries 16 fractional bits, a longer segment would lose codes
+    assert(lut.shift <= Lut::kFracBits);
+    const uint32_t seg_len = uint32_t{1} << lut.shift;
+
+    double kelvin[kCodes]{};
+    for (uint32_t x = first; x <= last; ++x) {
+        kelvin[x] = adc_to_kelvin(x, kBits, thermistor, r_div);
+    }
+
+    for (std::size_t s = 0; s < kSegments; ++s) {
+        const uint32_t x0 = first + static_cast<uint32_t>(s) * seg_len;
+        if (x0 > last) {
+            // Past the range, clamping never reaches it
+            lut.coeffs[s] = lut.coeffs[s - 1];
+            continue;
+        }
+        const uint32_t n = std::min<uint32_t>(seg_len, last - x0 + 1);
+        const auto fit = fit_segment<kDegree, kLawsonIterations, kCodes>(kelvin + x0, n, seg_len);
+        for (std::size_t k = 0; k <= kDegree; ++k) {
+            const double c = fit[k]*mult;
+            // Fails constant evaluation when a coefficient does not fit Q16.16
+            assert(c > INT32_MIN && c < INT32_MAX);
+            lut.coeffs[s][k] = static_cast<int32_t>(c < 0 ? c - 0.5 : c + 0.5);
+        }
+    }
+
+    for (uint32_t x = first; x <= last; ++x) {
+        const double err = lut(x) / mult - kelvin[x];
+        lut.max_error_k = std::max(lut.max_error_k, err < 0 ? -err : err);
+    }
+    return lut;
+}
+
+
+/*
+ * Batch conversion kernels.
+ *
+ * Each kernel converts a buffer of ADC codes with the same segment lookup and
+ * rounding as interpolate(), so every kernel gives the same result for the
+ * same input. On x86 hosts the widest kernel the CPU supports is picked at
+ * runtime. Other targets use the scalar loop.
+ *
+ * The vector kernels do the interpolation divide in double precision. The
+ * operands are integers well below 2^53, so the correctly rounded quotient
+ * truncates to the same value as the integer divide. For power of two steps,
+ * like interpolate_sloped(), the index is a shift and the divide is a
+ * multiply by 1/step, which is exact.
+ */
+struct LutKernels {
+    const char* name;
+    void (*interpolate)(const AdcSpacing& spacing, const uint32_t* y_vals, std::size_t n,
+                        const uint32_t* x, uint32_t* y, std::size_t count);
+};
+
+namespace lut_scalar {
+inline void interpolate(const AdcSpacing& spacing, const uint32_t* y_vals, const std::size_t n,
+                        const uint32_t* x, uint32_t* y, const std::size_t count) {
+    const uint32_t x_max = spacing.at(n - 1);
+    for (std::size_t k = 0; k < count; ++k) {
+        const uint32_t xc = std::clamp<uint32_t>(x[k], spacing.start, x_max);
+        const std::size_t i = std::min<std::size_t>((xc - spacing.start) / spacing.step, n - 2);
+        const int64_t y0 = static_cast<int64_t>(y_vals[i]);
+        const int64_t y1 = static_cast<int64_t>(y_vals[i + 1]);
+        y[k] = static_cast<uint32_t>(y0 + (y1 - y0) * static_cast<int64_t>(xc - spacing.at(i)) / spacing.step);
+    }
+}
+
+inline constexpr LutKernels kernels{"scalar", &interpolate};
+}  // namespace lut_scalar
+
+#if THERMISTOR_LUT_HAS_X86_KERNELS
+namespace lut_sse41 {
+// p / step truncated, an exact multiply by the reciprocal for power of two steps
+template<bool kPow2>
+__attribute__((target("sse4.1")))
+inline __m128i quotient(const __m128d p, const __m128d step, const __m128d inv_step) {
+    return _mm_cvttpd_epi32(kPow2 ? _mm_mul_pd(p, inv_step) : _mm_div_pd(p, step));
+}
+
+template<bool kPow2>
+__attribute__((target("sse4.1")))
+inline void interpolate_step(const AdcSpacing& spacing, const uint32_t* y_vals, const std::size_t n,
+                             const uint32_t* x, uint32_t* y, const std::size_t count) {
+    const __m128i start = _mm_set1_epi32(static_cast<int>(spacing.start));
+    const __m128i x_max = _mm_set1_epi32(static_cast<int>(spacing.at(n - 1)));
+    const __m128i i_max = _mm_set1_epi32(static_cast<int>(n - 2));
+    const __m128i step_i = _mm_set1_epi32(static_cast<int>(spacing.step));
+    const __m128i shift = _mm_cvtsi32_si128(static_cast<int>(spacing.step_shift()));
+    const __m128d step = _mm_set1_pd(spacing.step);
+    const __m128d inv_step = _mm_set1_pd(1.0 / spacing.step);
+
+    std::size_t k = 0;
+    for (; k + 4 <= count; k += 4) {
+        __m128i xv = _mm_loadu_si128(reinterpret_cast<const __m128i*>(x + k));
+        xv = _mm_min_epu32(_mm_max_epu32(xv, start), x_max);
+        const __m128i offset = _mm_sub_epi32(xv, start);
+
+        __m128i idx;
+        if constexpr (kPow2) {
+            idx = _mm_min_epi32(_mm_srl_epi32(offset, shift), i_max);
+        } else {
+            // Two lanes at a time through double
+            const __m128i ilo = quotient<false>(_mm_cvtepi32_pd(offset), step, inv_step);
+            const __m128i ihi = quotient<false>(_mm_cvtepi32_pd(_mm_unpackhi_epi64(offset, offset)), step, inv_step);
+            idx = _mm_min_epi32(_mm_unpacklo_epi64(ilo, ihi), i_max);
+        }
+
+        alignas(16) int32_t lanes[4];
+        _mm_store_si128(reinterpret_cast<__m128i*>(lanes), idx);
+        const __m128i y0 = _mm_setr_epi32(static_cast<int>(y_vals[lanes[0]]), static_cast<int>(y_vals[lanes[1]]),
+                                          static_cast<int>(y_vals[lanes[2]]), static_cast<int>(y_vals[lanes[3]]));
+        const __m128i y1 = _mm_setr_epi32(static_cast<int>(y_vals[lanes[0] + 1]), static_cast<int>(y_vals[lanes[1] + 1]),
+                                          static_cast<int>(y_vals[lanes[2] + 1]), static_cast<int>(y_vals[lanes[3] + 1]));
+
+        const __m128i frac = _mm_sub_epi32(offset, kPow2 ? _mm_sll_epi32(idx, shift) : _mm_mullo_epi32(idx, step_i));
+        const __m128i dy = _mm_sub_epi32(y1, y0);
+
+        const __m128d plo = _mm_mul_pd(_mm_cvtepi32_pd(dy), _mm_cvtepi32_pd(frac));
+        const __m128d phi = _mm_mul_pd(_mm_cvtepi32_pd(_mm_unpackhi_epi64(dy, dy)),
+                                       _mm_cvtepi32_pd(_mm_unpackhi_epi64(frac, frac)));
+        const __m128i qlo = quotient<kPow2>(plo, step, inv_step);
+        const __m128i qhi = quotient<kPow2>(phi, step, inv_step);
+
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(y + k), _mm_add_epi32(y0, _mm_unpacklo_epi64(qlo, qhi)));
+    }
+    lut_scalar::interpolate(spacing, y_vals, n, x + k, y + k, count - k);
+}
+
+inline void interpolate(const AdcSpacing& spacing, const uint32_t* y_vals, const std::size_t n,
+                        const uint32_t* x, uint32_t* y, const std::size_t count) {
+    if (spacing.is_pow2()) {
+        interpolate_step<true>(spacing, y_vals, n, x, y, count);
+    } else {
+        interpolate_step<false>(spacing, y_vals, n, x, y, count);
+    }
+}
+
+inline constexpr LutKernels kernels{"sse4.1", &interpolate};
+}  // namespace lut_sse41
+
+namespace lut_avx2 {
+template<bool kPow2>
+__attribute__((target("avx2")))
+inline __m128i quotient(const __m256d p, const __m256d step, const __m256d inv_step) {
+    return _mm256_cvttpd_epi32(kPow2 ? _mm256_mul_pd(p, inv_step) : _mm256_div_pd(p, step));
+}
+
+template<bool kPow2>
+__attribute__((target("avx2")))
+inline void interpolate_step(const AdcSpacing& spacing, const uint32_t* y_vals, const std::size_t n,
+                             const uint32_t* x, uint32_t* y, const std::size_t count) {
+    const __m256i start = _mm256_set1_epi32(static_cast<int>(spacing.start));
+    const __m256i x_max = _mm256_set1_epi32(static_cast<int>(spacing.at(n - 1)));
+    const __m256i i_max = _mm256_set1_epi32(static_cast<int>(n - 2));
+    const __m256i step_i = _mm256_set1_epi32(static_cast<int>(spacing.step));
+    const __m128i shift = _mm_cvtsi32_si128(static_cast<int>(spacing.step_shift()));
+    const __m256d step = _mm256_set1_pd(spacing.step);
+    const __m256d inv_step = _mm256_set1_pd(1.0 / spacing.step);
+    const int* table = reinterpret_cast<const int*>(y_vals);
+
+    std::size_t k = 0;
+    for (; k + 8 <= count; k += 8) {
+        __m256i xv = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(x + k));
+        xv = _mm256_min_epu32(_mm256_max_epu32(xv, start), x_max);
+        const __m256i offset = _mm256_sub_epi32(xv, start);
+
+        __m256i idx;
+        if constexpr (kPow2) {
+            idx = _mm256_min_epi32(_mm256_srl_epi32(offset, shift), i_max);
+        } else {
+            const __m128i ilo = quotient<false>(_mm256_cvtepi32_pd(_mm256_castsi256_si128(offset)), step, inv_step);
+            const __m128i ihi = quotient<false>(_mm256_cvtepi32_pd(_mm256_extracti128_si256(offset, 1)), step, inv_step);
+            idx = _mm256_min_epi32(_mm256_set_m128i(ihi, ilo), i_max);
+        }
+
+        const __m256i y0 = _mm256_i32gather_epi32(table, idx, 4);
+        const __m256i y1 = _mm256_i32gather_epi32(table + 1, idx, 4);
+
+        const __m256i frac = _mm256_sub_epi32(offset, kPow2 ? _mm256_sll_epi32(idx, shift) : _mm256_mullo_epi32(idx, step_i));
+        const __m256i dy = _mm256_sub_epi32(y1, y0);
+
+        const __m256d plo = _mm256_mul_pd(_mm256_cvtepi32_pd(_mm256_castsi256_si128(dy)),
+                                          _mm256_cvtepi32_pd(_mm256_castsi256_si128(frac)));
+        const __m256d phi = _mm256_mul_pd(_mm256_cvtepi32_pd(_mm256_extracti128_si256(dy, 1)),
+                                          _mm256_cvtepi32_pd(_mm256_extracti128_si256(frac, 1)));
+        const __m128i qlo = quotient<kPow2>(plo, step, inv_step);
+        const __m128i qhi = quotient<kPow2>(phi, step, inv_step);
+
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(y + k), _mm256_add_epi32(y0, _mm256_set_m128i(qhi, qlo)));
+    }
+    lut_scalar::interpolate(spacing, y_vals, n, x + k, y + k, count - k);
+}
+
+inline void interpolate(const AdcSpacing& spacing, const uint32_t* y_vals, const std::size_t n,
+                        const uint32_t* x, uint32_t* y, const std::size_t count) {
+    if (spacing.is_pow2()) {
+        interpolate_step<true>(spacing, y_vals, n, x, y, count);
+    } else {
+        interpolate_step<false>(spacing, y_vals, n, x, y, count);
+    }
+}
+
+inline constexpr LutKernels kernels{"avx2", &interpolate};
+}  // namespace lut_avx2
+#endif
+
+inline const LutKernels& select_lut_kernels() {
+#if THERMISTOR_LUT_HAS_X86_KERNELS
+    if (__builtin_cpu_supports("avx2")) {
+        return lut_avx2::kernels;
+    }
+    if (__builtin_cpu_supports("sse4.1")) {
+        return lut_sse41::kernels;
+    }
+#endif
+    return lut_scalar::kernels;
+}
+
+inline const LutKernels& lut_kernels() {
+    static const LutKernels& kernels = select_lut_kernels();
+    return kernels;
+}
+
+/*
+ * Converts x.size() ADC codes into y, which must be at least as long.
+ * Table values must be below 2^31, true for Q16.16 temperatures in Kelvin.
+ */
+template <std::size_t N>
+inline void interpolate_batch(const AdcSpacing& spacing, const std::array<uint32_t, N>& y_vals,
+                              std::span<const uint32_t> x, std::span<uint32_t> y) {
+    static_assert(N >= 2, "x_vals and y_vals must have at least two elements");
+    assert(y.size() >= x.size());
+    lut_kernels().interpolate(spacing, y_vals.data(), N, x.data(), y.data(), x.size());
+}
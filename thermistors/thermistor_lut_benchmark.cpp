@@ -0,0 +1,125 @@
+/*
+ * Host benchmark for the thermistor conversion paths.
+ *
+ *   g++ -std=c++20 -O2 -march=native thermistor_lut_benchmark.cpp thermistor_lut_example.cpp -o thermistor_lut_benchmark
+ *
+ * Converts a buffer of random 12 bit ADC codes with each strategy and prints
+ * the cost per sample, the largest difference from interpolate() in LSB and
+ * the largest error against double precision Steinhart-Hart over the table
+ * range and over the part's rated range.
+ * On x86 the cost is in TSC ticks, elsewhere in nanoseconds.
+ */
+#include "thermistor_lut_example.hpp"
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <random>
+#include <vector>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+static uint64_t now_ticks() { return __rdtsc(); }
+static const char* const kTickUnit = "ticks";
+#else
+static uint64_t now_ticks() {
+    return static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count());
+}
+static const char* const kTickUnit = "ns";
+#endif
+
+constexpr std::size_t kSamples = 1 << 16;
+constexpr int kRepeats = 200;
+
+struct Strategy {
+    const char* name;
+    void (*convert)(std::span<const uint32_t> adc, std::span<uint32_t> temps);
+};
+
+static void convert_interpolate(std::span<const uint32_t> adc, std::span<uint32_t> temps) {
+    for (std::size_t i = 0; i < adc.size(); ++i) {
+        temps[i] = calculate_temperature_q16(adc[i]);
+    }
+}
+
+static void convert_sloped(std::span<const uint32_t> adc, std::span<uint32_t> temps) {
+    for (std::size_t i = 0; i < adc.size(); ++i) {
+        temps[i] = calculate_temperature_q16_sloped(adc[i]);
+    }
+}
+
+static void convert_nonuniform(std::span<const uint32_t> adc, std::span<uint32_t> temps) {
+    for (std::size_t i = 0; i < adc.size(); ++i) {
+        temps[i] = calculate_temperature_q16_nonuniform(adc[i]);
+    }
+}
+
+static void convert_polynomial(std::span<const uint32_t> adc, std::span<uint32_t> temps) {
+    for (std::size_t i = 0; i < adc.size(); ++i) {
+        temps[i] = calculate_temperature_q16_polynomial(adc[i]);
+    }
+}
+
+// Largest error in Kelvin over codes first to last
+static double max_error_k(const Strategy& s, const uint32_t first, const uint32_t last) {
+    std::vector<uint32_t> codes(last - first + 1);
+    std::vector<uint32_t> code_temps(codes.size());
+    for (std::size_t i = 0; i < codes.size(); ++i) {
+        codes[i] = first + static_cast<uint32_t>(i);
+    }
+    s.convert(codes, code_temps);
+    double max_err = 0;
+    for (std::size_t i = 0; i < codes.size(); ++i) {
+        const double err = code_temps[i] / 65536.0 - adc_to_kelvin(codes[i], adc_bits, thermistor);
+        max_err = std::max(max_err, std::abs(err));
+    }
+    return max_err;
+}
+
+static const Strategy strategies[] = {
+    {"interpolate", &convert_interpolate},
+    {"sloped", &convert_sloped},
+    {"batch", &calculate_temperatures_q16},
+    {"nonuniform", &convert_nonuniform},
+    {"polynomial", &convert_polynomial},
+};
+
+int main() {
+    std::mt19937 gen{1};
+    std::uniform_int_distribution<uint32_t> dist{0, adc_max};
+    std::vector<uint32_t> adc(kSamples);
+    for (auto& a : adc) {
+        a = dist(gen);
+    }
+
+    std::vector<uint32_t> reference(kSamples);
+    convert_interpolate(adc, reference);
+
+    std::printf("uniform lut: %zu entries, %zu bytes (%zu with slopes)\n", lut.size(), sizeof(lut),
+                sizeof(lut) + sizeof(lut_slopes));
+    std::printf("nonuniform lut: %zu entries, %zu bytes\n", lut_breakpoints.size, lut_nonuniform.bytes());
+    std::printf("polynomial: %zu segments of degree 3, %zu bytes, codes %u to %u\n\n", lut_polynomial.coeffs.size(),
+                lut_polynomial.bytes(), rated_codes.first, rated_codes.last);
+
+    std::printf("%-12s %10s %10s %12s %12s\n", "strategy", kTickUnit, "max diff", "max err K", "rated err K");
+    std::vector<uint32_t> temps(kSamples);
+    for (const auto& s : strategies) {
+        uint64_t best = UINT64_MAX;
+        for (int r = 0; r < kRepeats; ++r) {
+            const uint64_t t0 = now_ticks();
+            s.convert(adc, temps);
+            const uint64_t t1 = now_ticks();
+            best = std::min(best, t1 - t0);
+        }
+        int64_t max_diff = 0;
+        for (std::size_t i = 0; i < kSamples; ++i) {
+            max_diff = std::max<int64_t>(max_diff, std::llabs(static_cast<int64_t>(temps[i]) - static_cast<int64_t>(reference[i])));
+        }
+
+        std::printf("%-12s %10.2f %10lld %12.4f %12.4f\n", s.name, static_cast<double>(best) / kSamples,
+                    static_cast<long long>(max_diff), max_error_k(s, spacing.start, spacing.max()),
+                    max_error_k(s, rated_codes.first, rated_codes.last));
+    }
+    return 0;
+}
@@ -0,0 +1,133 @@
+#pragma once
+
+#include "thermistor_lut.hpp"
+
+const unsigned adc_bits = 12;
+const unsigned adc_max = (1<<adc_bits)-1;
+const std::size_t kLutSize = 128;
+const constexpr AdcSpacing spacing {
+    start: 8,
+    step: 32,
+    size: kLutSize
+};
+
+const constexpr Thermistor thermistor{
+    A: 8.794452e-04, 
+    B:2.525972e-04, 
+    C:1.897193e-07,
+    R: 10e3};
+
+
+// Fit sanity check, R25 of the part is 10k
+static_assert(steinhart_hart_equations(10e3, thermistor) > 298.15 - 0.05 &&
+              steinhart_hart_equations(10e3, thermistor) < 298.15 + 0.05,
+              "thermistor coefficients do not give 25C at 10k");
+
+inline const constexpr auto lut = calc_lut<kLutSize,16>(spacing, adc_bits, thermistor);
+
+// The same curve at any ADC width, table size and output format
+template<unsigned int kBits, std::size_t kSize=kLutSize, typename Format=KelvinQ16>
+inline constexpr auto thermistor_table = make_thermistor_table<kBits, kSize, Format>(thermistor);
+static_assert(thermistor_table<adc_bits>.y == lut, "templated table differs from lut");
+
+// Half size tables for channels reporting Celsius
+inline const constexpr auto lut_centi_c = thermistor_table<adc_bits, kLutSize, CentiCelsius>;
+inline const constexpr auto lut_q8_8_c = thermistor_table<adc_bits, kLutSize, CelsiusQ8_8>;
+
+inline const constexpr auto lut_slopes = calc_slopes<8>(spacing, lut);
+static_assert(spacing.is_pow2(), "the sloped path relies on a shift for the index");
+
+// Same ADC range as lut, breakpoints placed for a 0.02K worst case error
+inline const constexpr auto lut_breakpoints = place_breakpoints<adc_bits>(spacing.start, spacing.max(), thermistor, 0.02);
+inline const constexpr auto lut_nonuniform = make_nonuniform_lut<lut_breakpoints.size>(lut_breakpoints);
+
+// ADC codes inside the part's rated -40C to 125C
+struct AdcRange {
+    uint32_t first;
+    uint32_t last;
+};
+inline constexpr AdcRange rated_codes = [] {
+    AdcRange range{adc_max, 0};
+    // The rails are a shorted or open thermistor
+    for (uint32_t x = 1; x < adc_max; ++x) {
+        const double k = adc_to_kelvin(x, adc_bits, thermistor);
+        if (k >= 273.15 - 40 && k <= 273.15 + 125) {
+            range.first = std::min(range.first, x);
+            range.last = std::max(range.last, x);
+        }
+    }
+    return range;
+}();
+
+// 16 cubic segments over the rated range, 268 bytes against 512 for lut
+inline const constexpr auto lut_polynomial = fit_polynomial_lut<adc_bits, 16, 3>(rated_codes.first, rated_codes.last, thermistor);
+static_assert(lut_polynomial.max_error_k < 0.05, "polynomial fit worse than 0.05K over the rated range");
+
+std::array<uint32_t, kLutSize> get_lut();
+
+// Q16.16
+uint32_t calculate_temperature_q16(const uint32_t adc);
+
+// Q16.16, division free using lut_slopes, within 1 LSB of calculate_temperature_q16
+uint32_t calculate_temperature_q16_sloped(const uint32_t adc);
+
+// Q16.16 from lut_nonuniform, within 0.02K of Steinhart-Hart over the lut range
+uint32_t calculate_temperature_q16_nonuniform(const uint32_t adc);
+
+// Q16.16 from lut_polynomial, clamped to the rated range
+uint32_t calculate_temperature_q16_polynomial(const uint32_t adc);
+
+// Hundredths of a degree Celsius
+int16_t calculate_temperature_centi_c(const uint32_t adc);
+
+// Celsius Q8.8
+int16_t calculate_temperature_q8_8_c(const uint32_t adc);
+
+// Per channel choice of conversion, trading table memory against cycles
+enum class TemperatureConversion {
+    kLut,
+    kSloped,
+    kNonUniform,
+    kPolynomial
+};
+
+// Q16.16 with the channel's conversion
+uint32_t calculate_temperature_q16(const TemperatureConversion conversion, const uint32_t adc);
+
+// Setpoints in ADC counts, 64 entries over the rated range
+inline const constexpr auto lut_inverse = calc_inverse_lut<64>(spacing, lut, adc_bits, celsius_to_kelvin_q16(-40),
+                                                               celsius_to_kelvin_q16(125));
+
+/*
+ * ADC threshold for a Q16.16 Kelvin setpoint, calculate_temperature_q16(adc)
+ * is above the setpoint exactly when adc is below the threshold.
+ */
+constexpr uint32_t adc_threshold(const uint32_t kelvin_q16) {
+    return lut_inverse.threshold(lut, kelvin_q16);
+}
+
+// Example alarm, compared against raw samples
+inline constexpr uint32_t adc_over_temperature = adc_threshold(celsius_to_kelvin_q16(85));
+
+/*
+ * Oversampled channels take 16 raw samples per output, drop the highest and
+ * lowest and average the rest to a code with 2 fraction bits.
+ */
+using TemperatureDecimator = AdcDecimator<16, 2>;
+inline constexpr AdcSpacing spacing_oversampled = TemperatureDecimator::oversampled(spacing);
+
+// Q16.16 for a TemperatureDecimator output code, same table as calculate_temperature_q16
+uint32_t calculate_temperature_q16_oversampled(const uint32_t adc_q);
+
+/*
+ * Filters a block of raw samples and converts once per output, temps must
+ * hold adc.size() / 16 + 1 values. Returns the number of temperatures written.
+ * A partial block stays in the decimator for the next call.
+ */
+std::size_t filter_temperatures_q16(TemperatureDecimator& decimator, std::span<const uint32_t> adc, std::span<uint32_t> temps);
+
+/*
+ * Converts a block of ADC samples, temps must be at least as long as adc.
+ * Same results as calculate_temperature_q16 for each sample.
+ */
+void calculate_temperatures_q16(std::span<const uint32_t> adc, std::span<uint32_t> temps);
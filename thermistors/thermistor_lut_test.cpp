@@ -0,0 +1,323 @@
+/*
+ * Host accuracy and throughput harness for the thermistor conversions.
+ *
+ *   g++ -std=c++20 -O2 thermistor_lut_test.cpp thermistor_lut_example.cpp -o thermistor_lut_test && ./thermistor_lut_test
+ *
+ * Sweeps every 12 bit ADC code through each conversion, compares against
+ * double precision Steinhart-Hart and prints the max and RMS error over the
+ * table range and over the part's rated range, then the throughput of each
+ * conversion in samples per second, then the rated range error of the
+ * templated tables at every ADC width and output format. Exits non-zero when
+ * a conversion is less accurate than its bound or breaks one of the exact
+ * relations between the paths, so a faster path cannot quietly lose accuracy.
+ * The generated thermistor_registry.hpp is checked against its own fit and
+ * constexpr_log against std::log.
+ */
+#include "thermistor_lut_example.hpp"
+#include "thermistor_registry.hpp"
+
+#include <bit>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <random>
+#include <utility>
+#include <vector>
+
+constexpr uint32_t kCodes = adc_max + 1;
+
+static int failures = 0;
+
+static void check(const bool ok, const char* what) {
+    if (!ok) {
+        std::printf("FAIL: %s\n", what);
+        failures++;
+    }
+}
+
+struct Strategy {
+    const char* name;
+    uint32_t (*convert)(uint32_t adc);
+    // Worst error allowed over the rated range, Kelvin
+    double rated_bound_k;
+    // Whole buffer conversion for the throughput run, when the path has one
+    void (*convert_block)(std::span<const uint32_t> adc, std::span<uint32_t> temps) = nullptr;
+};
+
+static uint32_t convert_batch(const uint32_t adc) {
+    uint32_t temp = 0;
+    calculate_temperatures_q16(std::span<const uint32_t>(&adc, 1), std::span<uint32_t>(&temp, 1));
+    return temp;
+}
+
+static uint32_t convert_oversampled(const uint32_t adc) {
+    return calculate_temperature_q16_oversampled(adc << TemperatureDecimator::frac_bits);
+}
+
+static const Strategy strategies[] = {
+    {"interpolate", &calculate_temperature_q16, 0.15},
+    {"sloped", &calculate_temperature_q16_sloped, 0.15},
+    {"batch", &convert_batch, 0.15, &calculate_temperatures_q16},
+    {"nonuniform", &calculate_temperature_q16_nonuniform, 0.02},
+    {"polynomial", &calculate_temperature_q16_polynomial, 0.05},
+    {"oversampled", &convert_oversampled, 0.15},
+};
+
+struct ErrorStats {
+    double max_k = 0;
+    double rms_k = 0;
+};
+
+static ErrorStats error_stats(const Strategy& s, const uint32_t first, const uint32_t last) {
+    ErrorStats stats{};
+    double sum_sq = 0;
+    for (uint32_t x = first; x <= last; ++x) {
+        const double err = s.convert(x) / 65536.0 - adc_to_kelvin(x, adc_bits, thermistor);
+        stats.max_k = std::max(stats.max_k, std::abs(err));
+        sum_sq += err*err;
+    }
+    stats.rms_k = std::sqrt(sum_sq / (last - first + 1));
+    return stats;
+}
+
+static double samples_per_second(const Strategy& s, const std::vector<uint32_t>& adc) {
+    using clock = std::chrono::steady_clock;
+    constexpr int kRepeats = 50;
+    double best = 0;
+    volatile uint32_t sink = 0;
+    std::vector<uint32_t> temps(adc.size());
+    for (int r = 0; r < kRepeats; ++r) {
+        uint32_t acc = 0;
+        const auto t0 = clock::now();
+        if (s.convert_block) {
+            s.convert_block(adc, temps);
+            acc = temps.back();
+        } else {
+            for (const uint32_t x : adc) {
+                acc += s.convert(x);
+            }
+        }
+        const auto t1 = clock::now();
+        sink = sink + acc;
+        const double seconds = std::chrono::duration<double>(t1 - t0).count();
+        best = std::max(best, adc.size() / seconds);
+    }
+    return best;
+}
+
+// Rated range error of one table, and of the Q16.16 table at the same width
+template<unsigned int kBits, typename Format>
+static void check_table() {
+    constexpr auto& table = thermistor_table<kBits, kLutSize, Format>;
+    constexpr auto& reference = thermistor_table<kBits, kLutSize, KelvinQ16>;
+    constexpr uint32_t codes = uint32_t{1} << kBits;
+    double max_err = 0;
+    double reference_err = 0;
+    for (uint32_t x = 1; x + 1 < codes; ++x) {
+        const double k = adc_to_kelvin(x, kBits, thermistor);
+        if (k < 273.15 - 40 || k > 273.15 + 125) {
+            continue;
+        }
+        max_err = std::max(max_err, std::abs(Format::to_kelvin(table(x)) - k));
+        reference_err = std::max(reference_err, std::abs(KelvinQ16::to_kelvin(reference(x)) - k));
+    }
+    // One output LSB for rounding the entries, one for the interpolation
+    const double lsb = Format::to_kelvin(1) - Format::to_kelvin(0);
+    std::printf("%2u bit %-9s %6zu bytes %12.4f\n", kBits, Format::name, table.bytes(), max_err);
+    if (max_err > reference_err + 2*lsb) {
+        std::printf("FAIL: %u bit %s table error %.4f K, Q16.16 has %.4f K\n", kBits, Format::name, max_err, reference_err);
+        failures++;
+    }
+}
+
+template<typename Format, unsigned int... kBits>
+static void check_tables(std::integer_sequence<unsigned int, kBits...>) {
+    (check_table<kBits, Format>(), ...);
+}
+
+int main() {
+    // Exact relations between the paths, over every code
+    bool batch_exact = true;
+    bool sloped_1lsb = true;
+    bool oversampled_exact = true;
+    bool monotonic = true;
+    std::vector<uint32_t> all(kCodes);
+    std::vector<uint32_t> all_batch(kCodes);
+    for (uint32_t x = 0; x < kCodes; ++x) {
+        all[x] = x;
+    }
+    calculate_temperatures_q16(all, all_batch);
+    for (uint32_t x = 0; x < kCodes; ++x) {
+        const uint32_t y = calculate_temperature_q16(x);
+        batch_exact &= all_batch[x] == y;
+        sloped_1lsb &= std::abs(static_cast<int64_t>(calculate_temperature_q16_sloped(x)) - y) <= 1;
+        oversampled_exact &= convert_oversampled(x) == y;
+        monotonic &= x == 0 || y <= calculate_temperature_q16(x - 1);
+    }
+    check(batch_exact, "batch kernels differ from interpolate");
+    check(sloped_1lsb, "sloped path more than 1 LSB from interpolate");
+    check(oversampled_exact, "oversampled lookup differs from interpolate at whole codes");
+    check(monotonic, "interpolate is not decreasing with the ADC code");
+
+    // Every kernel the CPU has, on a power of two step and on one that is not
+    constexpr AdcSpacing odd_spacing{5, 24, 170};
+    static constexpr auto odd_lut = calc_lut<170>(odd_spacing, adc_bits, thermistor);
+    std::vector<const LutKernels*> kernels{&lut_scalar::kernels};
+#if THERMISTOR_LUT_HAS_X86_KERNELS
+    if (__builtin_cpu_supports("sse4.1")) {
+        kernels.push_back(&lut_sse41::kernels);
+    }
+    if (__builtin_cpu_supports("avx2")) {
+        kernels.push_back(&lut_avx2::kernels);
+    }
+#endif
+    for (const auto* k : kernels) {
+        std::vector<uint32_t> pow2_out(kCodes);
+        std::vector<uint32_t> odd_out(kCodes);
+        k->interpolate(spacing, lut.data(), lut.size(), all.data(), pow2_out.data(), kCodes);
+        k->interpolate(odd_spacing, odd_lut.data(), odd_lut.size(), all.data(), odd_out.data(), kCodes);
+        bool kernel_exact = true;
+        for (uint32_t x = 0; x < kCodes; ++x) {
+            kernel_exact &= pow2_out[x] == calculate_temperature_q16(x);
+            kernel_exact &= odd_out[x] == interpolate(odd_spacing, odd_lut, x);
+        }
+        if (!kernel_exact) {
+            std::printf("FAIL: %s batch kernel differs from interpolate\n", k->name);
+            failures++;
+        }
+    }
+
+    // Segment math: table codes return the table entries, including the last
+    bool on_table = true;
+    for (std::size_t i = 0; i < lut.size(); ++i) {
+        on_table &= calculate_temperature_q16(spacing.at(i)) == lut[i];
+    }
+    check(on_table, "interpolate does not return the table entry at a table code");
+    check(calculate_temperature_q16(0) == lut.front() && calculate_temperature_q16(adc_max) == lut.back(),
+          "codes outside the table are not clamped to the end entries");
+
+    // The nonuniform index lands in the same segment as a full search
+    bool index_exact = true;
+    for (uint32_t x = lut_nonuniform.x.front(); x <= lut_nonuniform.x.back(); ++x) {
+        index_exact &= lut_nonuniform.segment(x) == lut_nonuniform.search(x, 0, lut_breakpoints.size - 2);
+    }
+    check(index_exact, "nonuniform coarse index differs from a full search");
+
+    // Setpoint thresholds agree with the forward conversion
+    bool thresholds = true;
+    for (int c = -45; c <= 130; c += 5) {
+        const uint32_t t = celsius_to_kelvin_q16(c);
+        const uint32_t th = adc_threshold(t);
+        for (uint32_t x = 0; x < kCodes; ++x) {
+            thresholds &= (calculate_temperature_q16(x) > t) == (x < th);
+        }
+    }
+    check(thresholds, "adc_threshold disagrees with calculate_temperature_q16");
+
+    // Same at 16 bits, from 1K below the coldest entry so the first
+    // threshold is past the last code, 2^16
+    constexpr auto& table16 = thermistor_table<16>;
+    using Table16 = std::remove_cvref_t<decltype(table16)>;
+    static constexpr uint32_t coldest16 = table16.y.back() - 65536;
+    static constexpr auto inverse16 = calc_inverse_lut<64>(Table16::spacing, table16.y, 16, coldest16,
+                                                           celsius_to_kelvin_q16(125));
+    bool thresholds16 = true;
+    for (int c = -45; c <= 130; c += 5) {
+        const uint32_t t = celsius_to_kelvin_q16(c);
+        const uint32_t th = inverse16.threshold(table16.y, t);
+        for (uint32_t x = 0; x < (uint32_t{1} << 16); ++x) {
+            thresholds16 &= (table16(x) > t) == (x < th);
+        }
+    }
+    check(thresholds16, "16 bit inverse table disagrees with the forward table");
+    check(inverse16.threshold(table16.y, coldest16) == uint32_t{1} << 16,
+          "16 bit threshold below the coldest entry is not past the last code");
+
+    // A table with an entry per code has one at the rail, clamped cold
+    constexpr auto& full10 = thermistor_table<10, 1024>;
+    bool full_exact = true;
+    for (uint32_t x = 0; x < 1024; ++x) {
+        full_exact &= full10(x) == KelvinQ16::from_kelvin(adc_to_kelvin(x, 10, thermistor));
+    }
+    check(full_exact, "10 bit table with 1024 entries differs from adc_to_kelvin");
+    check(full10(1023) == KelvinQ16::from_kelvin(100), "10 bit table is not clamped cold at the rail");
+
+    // constexpr_log against std::log, densely over every mantissa and across
+    // the exponent range. std::log is rounded too, so 1 ulp apart is allowed.
+    double log_ulps = 0;
+    double log_worst_x = 0;
+    const auto log_check = [&](const double x) {
+        const double ref = std::log(x);
+        const double ulp = std::abs(std::nextafter(ref, INFINITY) - ref);
+        const double err = std::abs(constexpr_log(x) - ref) / ulp;
+        if (err > log_ulps) {
+            log_ulps = err;
+            log_worst_x = x;
+        }
+    };
+    log_check(1.1264306529435821);
+    log_check(1.2810820023864007);
+    std::mt19937_64 log_gen{1};
+    for (uint64_t i = 0; i < (uint64_t{1} << 22); ++i) {
+        // [0.5, 2), the top 23 mantissa bits swept and the rest random
+        log_check(std::bit_cast<double>(0x3fe0000000000000ull + (i << 30) + (log_gen() & ((uint64_t{1} << 30) - 1))));
+    }
+    std::uniform_real_distribution<double> log_exp{-1020, 1020};
+    for (int i = 0; i < (1 << 20); ++i) {
+        log_check(std::exp2(log_exp(log_gen)));
+        log_check(std::bit_cast<double>(log_gen() & 0x000fffffffffffffull));  // subnormal
+    }
+    std::printf("constexpr_log worst %.0f ulp from std::log at %.17g\n\n", log_ulps, log_worst_x);
+    check(log_ulps <= 1, "constexpr_log more than 1 ulp from std::log");
+
+    std::printf("%-12s %12s %12s %12s %12s %14s\n", "strategy", "max err K", "rms err K", "rated max K",
+                "rated rms K", "samples/s");
+    std::mt19937 gen{1};
+    std::uniform_int_distribution<uint32_t> dist{0, adc_max};
+    std::vector<uint32_t> adc(1 << 16);
+    for (auto& a : adc) {
+        a = dist(gen);
+    }
+    for (const auto& s : strategies) {
+        const auto table = error_stats(s, spacing.start, spacing.max());
+        const auto rated = error_stats(s, rated_codes.first, rated_codes.last);
+        std::printf("%-12s %12.4f %12.4f %12.4f %12.4f %14.3e\n", s.name, table.max_k, table.rms_k, rated.max_k,
+                    rated.rms_k, samples_per_second(s, adc));
+        if (rated.max_k > s.rated_bound_k) {
+            std::printf("FAIL: %s rated range error %.4f K above %.4f K\n", s.name, rated.max_k, s.rated_bound_k);
+            failures++;
+        }
+    }
+
+    std::printf("\n%-16s %12s %12s\n", "table", "size", "rated max K");
+    using Widths = std::integer_sequence<unsigned int, 10, 11, 12, 13, 14, 15, 16>;
+    check_tables<KelvinQ16>(Widths{});
+    check_tables<CelsiusQ8_8>(Widths{});
+    check_tables<CentiCelsius>(Widths{});
+
+    // Generated registry, every table against the part's Steinhart-Hart fit
+    std::printf("\n%-16s %6s %4s %12s\n", "registry", "r_div", "bits", "rated max K");
+    const auto& part = thermistor_registry::ntcg103jx103dt1;
+    for (const auto& entry : thermistor_registry::luts) {
+        double max_err = 0;
+        for (uint32_t x = 1; x + 1 < (uint32_t{1} << entry.adc_bits); ++x) {
+            const double k = adc_to_kelvin(x, entry.adc_bits, part.thermistor, entry.r_div);
+            if (k < 273.15 + part.t_min_c || k > 273.15 + part.t_max_c) {
+                continue;
+            }
+            max_err = std::max(max_err, std::abs(entry(x) / 65536.0 - k));
+        }
+        std::printf("%-16.*s %6u %4u %12.4f\n", static_cast<int>(entry.part_number.size()),
+                    entry.part_number.data(), entry.r_div, entry.adc_bits, max_err);
+        // 128 entries, the 4k7 divider spends fewer codes on the hot end
+        if (max_err > 0.25) {
+            std::printf("FAIL: registry %u bit %u ohm table error %.4f K\n", entry.adc_bits, entry.r_div, max_err);
+            failures++;
+        }
+    }
+    check(thermistor_registry::find(part.part_number, 10000, 12) != nullptr, "registry has no 10k 12 bit table");
+    check(thermistor_registry::find(part.part_number, 10000, 16) == nullptr, "registry finds a table it does not hold");
+
+    std::printf("%s\n", failures ? "FAILED" : "OK");
+    return failures ? 1 : 0;
+}
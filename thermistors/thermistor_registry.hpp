@@ -0,0 +1,48 @@
+// Generated by gen_thermistor_registry.py, do not edit.
+// python3 gen_thermistor_registry.py ntcg103jx103dt1.csv --divider 10000 --divider 4700 --bits 10 --bits 12 -o thermistor_registry.hpp
+#pragma once
+
+#include "thermistor_lut.hpp"
+
+namespace thermistor_registry {
+
+inline constexpr AdcSpacing spacing_10bit{
+    start: 2,
+    step: 8,
+    size: 128
+};
+inline constexpr AdcSpacing spacing_12bit{
+    start: 8,
+    step: 32,
+    size: 128
+};
+
+// NTCG103JX103DT1, fit over -40C to 125C
+inline constexpr ThermistorPart ntcg103jx103dt1{
+    part_number: "NTCG103JX103DT1",
+    thermistor: {A: 8.794452476e-04, B: 2.525972009e-04, C: 1.897192720e-07, R: 10000},
+    t_min_c: -40,
+    t_max_c: 125,
+    fit_error_k: 0.1959
+};
+static_assert(steinhart_hart_equations(10000, ntcg103jx103dt1.thermistor) > 298.15 - ntcg103jx103dt1.fit_error_k - 0.01 &&
+              steinhart_hart_equations(10000, ntcg103jx103dt1.thermistor) < 298.15 + ntcg103jx103dt1.fit_error_k + 0.01,
+              "NTCG103JX103DT1 fit does not give 25C at R25");
+
+inline constexpr auto lut_ntcg103jx103dt1_10k_10bit = calc_lut<128,16>(spacing_10bit, 10, ntcg103jx103dt1.thermistor, 10000);
+inline constexpr auto lut_ntcg103jx103dt1_10k_12bit = calc_lut<128,16>(spacing_12bit, 12, ntcg103jx103dt1.thermistor, 10000);
+inline constexpr auto lut_ntcg103jx103dt1_4k7_10bit = calc_lut<128,16>(spacing_10bit, 10, ntcg103jx103dt1.thermistor, 4700);
+inline constexpr auto lut_ntcg103jx103dt1_4k7_12bit = calc_lut<128,16>(spacing_12bit, 12, ntcg103jx103dt1.thermistor, 4700);
+
+inline constexpr std::array<ThermistorLut, 4> luts{{
+    {ntcg103jx103dt1.part_number, 10000, 10, spacing_10bit, lut_ntcg103jx103dt1_10k_10bit},
+    {ntcg103jx103dt1.part_number, 10000, 12, spacing_12bit, lut_ntcg103jx103dt1_10k_12bit},
+    {ntcg103jx103dt1.part_number, 4700, 10, spacing_10bit, lut_ntcg103jx103dt1_4k7_10bit},
+    {ntcg103jx103dt1.part_number, 4700, 12, spacing_12bit, lut_ntcg103jx103dt1_4k7_12bit},
+}};
+
+constexpr const ThermistorLut* find(std::string_view part_number, const uint32_t r_div, const uint32_t adc_bits) {
+    return find_thermistor_lut(luts, part_number, r_div, adc_bits);
+}
+
+}  // namespace thermistor_registry
@@ -0,0 +1,136 @@
+/*
+ * Worker placement for the strategy matrix.
+ *
+ * Workers are pinned to the CPUs this process may run on, spread round robin
+ * across sockets so each socket gets an even share. Everything a worker
+ * allocates after pinning (players, piles, war buffers) is first touched on
+ * its own node, so the kernel's default first-touch policy keeps it local
+ * without linking libnuma. The thread_local RNG is the exception: its TLS
+ * block is set up by the thread that spawns the worker, and only its seed is
+ * written after pinning.
+ * */
+
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <fstream>
+#include <string>
+#include <vector>
+
+#if defined(__linux__)
+#include <pthread.h>
+#include <sched.h>
+#endif
+
+struct CpuInfo {
+  int cpu = -1;
+  int socket = 0;
+};
+
+inline int cpu_socket(int cpu) {
+  std::ifstream f{"/sys/devices/system/cpu/cpu" + std::to_string(cpu) +
+                  "/topology/physical_package_id"};
+  int socket = 0;
+  if (!(f >> socket) || socket < 0) {
+    socket = 0;
+  }
+  return socket;
+}
+
+/*
+ * CPUs in the process affinity mask, ordered so consecutive workers land on
+ * different sockets: the first CPU of each socket, then the second, ...
+ * */
+inline std::vector<CpuInfo> worker_cpus() {
+  std::vector<CpuInfo> cpus;
+#if defined(__linux__)
+  cpu_set_t set;
+  CPU_ZERO(&set);
+  if (sched_getaffinity(0, sizeof(set), &set) == 0) {
+    for (int cpu = 0; cpu < CPU_SETSIZE; cpu++) {
+      if (CPU_ISSET(cpu, &set)) {
+        cpus.push_back({cpu, cpu_socket(cpu)});
+      }
+    }
+  }
+#endif
+  std::vector<std::size_t> rank_in_socket(cpus.size());
+  std::vector<std::size_t> seen;
+  for (std::size_t i = 0; i < cpus.size(); i++) {
+    const auto socket = static_cast<std::size_t>(cpus[i].socket);
+    if (seen.size() <= socket) {
+      seen.resize(socket + 1, 0);
+    }
+    rank_in_socket[i] = seen[socket]++;
+  }
+  std::vector<std::size_t> order(cpus.size());
+  for (std::size_t i = 0; i < order.size(); i++) {
+    order[i] = i;
+  }
+  std::stable_sort(order.begin(), order.end(),
+                   [&](std::size_t a, std::size_t b) {
+                     return rank_in_socket[a] < rank_in_socket[b];
+                   });
+  std::vector<CpuInfo> interleaved;
+  interleaved.reserve(cpus.size());
+  for (auto i : order) {
+    interleaved.push_back(cpus[i]);
+  }
+  return interleaved;
+}
+
+inline bool pin_current_thread(int cpu) {
+#if defined(__linux__)
+  cpu_set_t set;
+  CPU_ZERO(&set);
+  CPU_SET(cpu, &set);
+  return pthread_setaffinity_np(pthread_self(), sizeof(set), &set) == 0;
+#else
+  (void)cpu;
+  return false;
+#endif
+}
+
+/*
+ * Filled in by each worker for its own slot, read after the worker's future
+ * is ready.
+ * */
+struct WorkerPlacement {
+  CpuInfo cpu{};
+  bool pinned = false;
+  double seconds = 0;
+  uint64_t games = 0;
+  uint64_t hands = 0;
+};
+
+struct SocketThroughput {
+  int socket = 0;
+  std::size_t workers = 0;
+  uint64_t games = 0;
+  uint64_t hands = 0;
+  //  Summed busy time of the socket's workers
+  double worker_seconds = 0;
+};
+
+inline std::vector<SocketThroughput>
+socket_throughput(const std::vector<WorkerPlacement> &workers) {
+  std::vector<SocketThroughput> sockets;
+  for (const auto &w : workers) {
+    const auto socket = static_cast<std::size_t>(w.cpu.socket);
+    if (sockets.size() <= socket) {
+      const auto first = sockets.size();
+      sockets.resize(socket + 1);
+      for (auto i = first; i < sockets.size(); i++) {
+        sockets[i].socket = static_cast<int>(i);
+      }
+    }
+    auto &s = sockets[socket];
+    s.workers++;
+    s.games += w.games;
+    s.hands += w.hands;
+    s.worker_seconds += w.seconds;
+  }
+  return sockets;
+}
@@ -0,0 +1,139 @@
+/*
+ * Rank kernels over contiguous card storage.
+ *
+ * Hands and piles are at most a deck in size so these are short loops, but the
+ * enrichment strategies call them on every shuffle decision. An AVX2 variant
+ * is selected at runtime when the CPU supports it, otherwise the scalar
+ * version is used. Both produce identical results.
+ * */
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#define WAR_SIMULATOR_HAS_AVX2_KERNELS 1
+#else
+#define WAR_SIMULATOR_HAS_AVX2_KERNELS 0
+#endif
+
+struct CardKernels {
+  const char *name;
+  //  Sum of all card ranks
+  uint64_t (*rank_sum)(const uint32_t *cards, std::size_t n);
+  //  Number of cards with lo <= rank <= hi
+  std::size_t (*count_rank_range)(const uint32_t *cards, std::size_t n,
+                                  uint32_t lo, uint32_t hi);
+  //  Adds the count of each rank to hist[rank], ranks >= nbins are ignored
+  void (*rank_histogram)(const uint32_t *cards, std::size_t n, uint32_t *hist,
+                         std::size_t nbins);
+};
+
+namespace scalar_kernels {
+inline uint64_t rank_sum(const uint32_t *cards, std::size_t n) {
+  uint64_t sum = 0;
+  for (std::size_t i = 0; i < n; i++) {
+    sum += cards[i];
+  }
+  return sum;
+}
+
+inline std::size_t count_rank_range(const uint32_t *cards, std::size_t n,
+                                    uint32_t lo, uint32_t hi) {
+  std::size_t cnt = 0;
+  for (std::size_t i = 0; i < n; i++) {
+    cnt += static_cast<std::size_t>(cards[i] >= lo && cards[i] <= hi);
+  }
+  return cnt;
+}
+
+inline void rank_histogram(const uint32_t *cards, std::size_t n,
+                           uint32_t *hist, std::size_t nbins) {
+  for (std::size_t i = 0; i < n; i++) {
+    if (cards[i] < nbins) {
+      hist[cards[i]] += 1;
+    }
+  }
+}
+
+inline constexpr CardKernels kernels{"scalar", &rank_sum, &count_rank_range,
+                                     &rank_histogram};
+} // namespace scalar_kernels
+
+#if WAR_SIMULATOR_HAS_AVX2_KERNELS
+namespace avx2_kernels {
+constexpr std::size_t kLanes = 8;
+
+__attribute__((target("avx2"))) inline uint32_t hsum(__m256i v) {
+  __m128i s = _mm_add_epi32(_mm256_castsi256_si128(v),
+                            _mm256_extracti128_si256(v, 1));
+  s = _mm_add_epi32(s, _mm_shuffle_epi32(s, _MM_SHUFFLE(1, 0, 3, 2)));
+  s = _mm_add_epi32(s, _mm_shuffle_epi32(s, _MM_SHUFFLE(2, 3, 0, 1)));
+  return static_cast<uint32_t>(_mm_cvtsi128_si32(s));
+}
+
+/*
+ * Lane sums cannot overflow: a lane sees at most n / 8 cards and card ranks are
+ * small, the inputs are bounded by the deck size.
+ * */
+__attribute__((target("avx2"))) inline uint64_t rank_sum(const uint32_t *cards,
+                                                         std::size_t n) {
+  __m256i acc = _mm256_setzero_si256();
+  std::size_t i = 0;
+  for (; i + kLanes <= n; i += kLanes) {
+    const __m256i v =
+        _mm256_loadu_si256(reinterpret_cast<const __m256i *>(cards + i));
+    acc = _mm256_add_epi32(acc, v);
+  }
+  return hsum(acc) + scalar_kernels::rank_sum(cards + i, n - i);
+}
+
+/*
+ * Ranks fit in a signed 32 bit lane so the signed compare is safe. Matching
+ * lanes are all ones (-1) and are subtracted from the accumulator.
+ * */
+__attribute__((target("avx2"))) inline std::size_t
+count_rank_range(const uint32_t *cards, std::size_t n, uint32_t lo,
+                 uint32_t hi) {
+  const __m256i below = _mm256_set1_epi32(static_cast<int>(lo) - 1);
+  const __m256i above = _mm256_set1_epi32(static_cast<int>(hi) + 1);
+  __m256i acc = _mm256_setzero_si256();
+  std::size_t i = 0;
+  for (; i + kLanes <= n; i += kLanes) {
+    const __m256i v =
+        _mm256_loadu_si256(reinterpret_cast<const __m256i *>(cards + i));
+    const __m256i in_range = _mm256_and_si256(_mm256_cmpgt_epi32(v, below),
+                                              _mm256_cmpgt_epi32(above, v));
+    acc = _mm256_sub_epi32(acc, in_range);
+  }
+  return hsum(acc) +
+         scalar_kernels::count_rank_range(cards + i, n - i, lo, hi);
+}
+
+/*
+ * The histogram stays scalar: it is a scatter into bins, and AVX2 has no
+ * conflict-free scatter, so a vector version needs a pass per bin.
+ * */
+inline constexpr CardKernels kernels{"avx2", &rank_sum, &count_rank_range,
+                                     &scalar_kernels::rank_histogram};
+} // namespace avx2_kernels
+#endif
+
+inline const CardKernels &select_card_kernels() {
+#if WAR_SIMULATOR_HAS_AVX2_KERNELS
+  if (__builtin_cpu_supports("avx2")) {
+    return avx2_kernels::kernels;
+  }
+#endif
+  return scalar_kernels::kernels;
+}
+
+/*
+ * Resolved once, the strategies call through this on every shuffle event.
+ * */
+inline const CardKernels &card_kernels() {
+  static const CardKernels &kernels = select_card_kernels();
+  return kernels;
+}
@@ -0,0 +1,160 @@
+/*
+ * Progress reporting for long matrix runs.
+ *
+ * Each strategy pair owns a PairProgress on its own cache line. The simulation
+ * thread is the only writer and publishes its running totals with relaxed
+ * stores, so there is no read-modify-write and no shared line between workers.
+ * A reporter thread samples all pairs on an interval and prints either a
+ * status line or a JSON line to stderr.
+ * */
+
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <cstdio>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+struct alignas(64) PairProgress {
+  std::size_t s1 = 0;
+  std::size_t s2 = 0;
+  uint64_t target_games = 0;
+  std::atomic<uint64_t> games{0};
+  std::atomic<uint64_t> hands{0};
+
+  //  Single writer, called by the simulation thread after each game
+  void publish(uint64_t ngames, uint64_t nhands) {
+    games.store(ngames, std::memory_order_relaxed);
+    hands.store(nhands, std::memory_order_relaxed);
+  }
+};
+
+enum class ProgressFormat { kNone, kText, kJson };
+
+//  Shorter intervals would have the reporter spin on wait_for(0ms)
+inline constexpr std::chrono::milliseconds kMinProgressInterval{1};
+
+class ProgressReporter {
+public:
+  ProgressReporter(const std::vector<std::unique_ptr<PairProgress>> &pairs,
+                   ProgressFormat format, std::chrono::milliseconds interval)
+      : pairs_{pairs}, format_{format},
+        interval_{std::max(interval, kMinProgressInterval)},
+        start_{std::chrono::steady_clock::now()} {
+    if (format_ != ProgressFormat::kNone) {
+      thread_ = std::thread([this]() { run(); });
+    }
+  }
+
+  ~ProgressReporter() { stop(); }
+
+  ProgressReporter(const ProgressReporter &) = delete;
+  ProgressReporter &operator=(const ProgressReporter &) = delete;
+
+  //  Prints a final sample and joins the reporter thread
+  void stop() {
+    if (!thread_.joinable()) {
+      return;
+    }
+    {
+      std::lock_guard<std::mutex> lock{mutex_};
+      done_ = true;
+    }
+    cv_.notify_one();
+    thread_.join();
+  }
+
+private:
+  struct Sample {
+    uint64_t games = 0;
+    uint64_t hands = 0;
+    uint64_t target = 0;
+    std::size_t pairs_done = 0;
+  };
+
+  Sample sample() const {
+    Sample s{};
+    for (const auto &p : pairs_) {
+      const auto games = p->games.load(std::memory_order_relaxed);
+      s.games += games;
+      s.hands += p->hands.load(std::memory_order_relaxed);
+      s.target += p->target_games;
+      s.pairs_done += static_cast<std::size_t>(games >= p->target_games);
+    }
+    return s;
+  }
+
+  void run() {
+    std::unique_lock<std::mutex> lock{mutex_};
+    bool done = false;
+    while (!done) {
+      done = cv_.wait_for(lock, interval_, [this]() { return done_; });
+      report(sample());
+    }
+  }
+
+  void report(const Sample &s) {
+    const double elapsed = std::chrono::duration<double>(
+                               std::chrono::steady_clock::now() - start_)
+                               .count();
+    const double dt = elapsed - last_elapsed_;
+    const double games_per_sec =
+        dt > 0 ? static_cast<double>(s.games - last_.games) / dt : 0.0;
+    const double hands_per_sec =
+        dt > 0 ? static_cast<double>(s.hands - last_.hands) / dt : 0.0;
+    const double avg_games_per_sec =
+        elapsed > 0 ? static_cast<double>(s.games) / elapsed : 0.0;
+    const double eta = avg_games_per_sec > 0
+                           ? static_cast<double>(s.target - s.games) /
+                                 avg_games_per_sec
+                           : 0.0;
+    const double pct =
+        s.target ? 100.0 * static_cast<double>(s.games) / s.target : 100.0;
+
+    if (format_ == ProgressFormat::kJson) {
+      std::fprintf(stderr,
+                   "{\"elapsed_s\": %.3f, \"games\": %llu, \"target_games\": "
+                   "%llu, \"hands\": %llu, \"games_per_s\": %.1f, "
+                   "\"hands_per_s\": %.1f, \"eta_s\": %.1f, \"pairs_done\": "
+                   "%zu, \"pairs\": [",
+                   elapsed, static_cast<unsigned long long>(s.games),
+                   static_cast<unsigned long long>(s.target),
+                   static_cast<unsigned long long>(s.hands), games_per_sec,
+                   hands_per_sec, eta, s.pairs_done);
+      for (std::size_t i = 0; i < pairs_.size(); i++) {
+        const auto &p = *pairs_[i];
+        std::fprintf(stderr, "%s[%zu, %zu, %llu]", i ? ", " : "", p.s1, p.s2,
+                     static_cast<unsigned long long>(
+                         p.games.load(std::memory_order_relaxed)));
+      }
+      std::fprintf(stderr, "]}\n");
+    } else {
+      std::fprintf(stderr,
+                   "[%7.1fs] %5.1f%% %llu/%llu games, %.0f games/s, %.0f "
+                   "hands/s, pairs %zu/%zu, eta %.0fs\n",
+                   elapsed, pct, static_cast<unsigned long long>(s.games),
+                   static_cast<unsigned long long>(s.target), games_per_sec,
+                   hands_per_sec, s.pairs_done, pairs_.size(), eta);
+    }
+    last_ = s;
+    last_elapsed_ = elapsed;
+  }
+
+  const std::vector<std::unique_ptr<PairProgress>> &pairs_;
+  ProgressFormat format_;
+  std::chrono::milliseconds interval_;
+  std::chrono::steady_clock::time_point start_;
+  Sample last_{};
+  double last_elapsed_ = 0;
+
+  std::mutex mutex_;
+  std::condition_variable cv_;
+  bool done_ = false;
+  std::thread thread_;
+};
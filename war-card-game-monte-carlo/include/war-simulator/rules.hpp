@@ -0,0 +1,50 @@
+/*
+ * Compile time rule policies.
+ *
+ * The game loop is instantiated per rule set so each variant gets its own
+ * specialised loop with the rules folded in as constants, rather than testing
+ * runtime flags on every hand.
+ * */
+
+#pragma once
+
+#include <cstddef>
+
+//  What happens when the flipped cards tie
+enum class TieRule {
+  //  Tied players go to war
+  kWar,
+  //  Each player takes back their own card, nobody wins the hand
+  kReturnCards
+};
+
+//  What happens when a player cannot put up a full war hand
+enum class ShortWarRule {
+  //  Play the cards that remain, the last one is flipped. A player with no
+  //  cards left when a war starts loses it.
+  kPlayRemaining,
+  //  A player without a full war hand loses the war
+  kForfeit
+};
+
+template <std::size_t kFaceDown_ = 3, TieRule kTie_ = TieRule::kWar,
+          ShortWarRule kShortWar_ = ShortWarRule::kPlayRemaining,
+          std::size_t kPlayers_ = 2>
+struct Rules {
+  static_assert(kPlayers_ >= 2 && kPlayers_ <= 8, "2 to 8 players");
+  static_assert(kFaceDown_ < 52 / kPlayers_, "war hand larger than a deal");
+
+  static constexpr std::size_t kFaceDown = kFaceDown_;
+  static constexpr TieRule kTie = kTie_;
+  static constexpr ShortWarRule kShortWar = kShortWar_;
+  static constexpr std::size_t kPlayers = kPlayers_;
+
+  //  Cards each player puts into a war, face down cards plus the flip
+  static constexpr std::size_t kWarSize = kFaceDown + 1;
+  //  Fewest cards a player needs to stay in a war
+  static constexpr std::size_t kMinWarCards =
+      kShortWar == ShortWarRule::kForfeit ? kWarSize : 1;
+};
+
+//  Three face down, one flipped, last card in a war loses
+using ClassicRules = Rules<>;
@@ -0,0 +1,335 @@
+/*
+ * Game traces.
+ *
+ * A sampled game reseeds the thread's generator from (run seed, stream id)
+ * before it is dealt, and every random choice in a game is drawn from that
+ * generator. Re-running the same strategies and rule set from the same stream
+ * reproduces the game exactly. The trace records the stream, the deal and
+ * each shuffle, so a replay can be checked byte for byte against the
+ * original.
+ *
+ * Only sampled games are traced. For the rest of the run the cost is one
+ * thread local pointer test per game and per shuffle.
+ *
+ * File layout, integers little endian:
+ *   "WARTRC" u8 version
+ *   records, each starting with a u8 tag:
+ *     kGameBegin  u8 rule_set, u8 s1, u8 s2, u64 seed, u64 stream
+ *     kDeal       u8 player, u8 n, n x u8 card
+ *     kShuffle    u8 player, u8 n, n x u8 card (hand after the shuffle)
+ *     kGameEnd    u8 winner (0xff for none), u32 hands
+ * */
+
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <fstream>
+#include <iostream>
+#include <iterator>
+#include <string>
+#include <vector>
+
+constexpr std::array<uint8_t, 6> kTraceMagic{'W', 'A', 'R', 'T', 'R', 'C'};
+constexpr uint8_t kTraceVersion = 1;
+constexpr uint8_t kTraceNoWinner = 0xff;
+constexpr std::size_t kTraceMaxPlayers = 8;
+
+enum class TraceTag : uint8_t {
+  kGameBegin = 1,
+  kDeal = 2,
+  kShuffle = 3,
+  kGameEnd = 4
+};
+
+inline uint64_t splitmix64(uint64_t x) {
+  x += 0x9e3779b97f4a7c15ull;
+  x = (x ^ (x >> 30)) * 0xbf58476d1ce4e5b9ull;
+  x = (x ^ (x >> 27)) * 0x94d049bb133111ebull;
+  return x ^ (x >> 31);
+}
+
+//  Seed words for std::seed_seq, distinct streams give unrelated generators
+inline std::array<uint32_t, 4> stream_seed(uint64_t seed, uint64_t stream) {
+  const uint64_t a = splitmix64(seed);
+  const uint64_t b = splitmix64(a ^ stream);
+  return {static_cast<uint32_t>(a), static_cast<uint32_t>(a >> 32),
+          static_cast<uint32_t>(b), static_cast<uint32_t>(b >> 32)};
+}
+
+class GameTracer {
+public:
+  uint64_t seed = 0;
+  //  Index of the strategy pair in the run, the high half of each stream id
+  uint32_t pair = 0;
+  uint8_t rule_set = 0;
+  //  Trace every Nth game of the pair, 0 disables tracing
+  std::size_t sample_every = 0;
+  //  Replays set this to reuse the stream of the recorded game
+  bool fixed_stream = false;
+  uint64_t stream = 0;
+
+  std::vector<uint8_t> bytes;
+
+  bool sampled(std::size_t game) const {
+    return sample_every && game % sample_every == 0;
+  }
+
+  uint64_t stream_for(std::size_t game) const {
+    return fixed_stream ? stream
+                        : (static_cast<uint64_t>(pair) << 32) | game;
+  }
+
+  //  Returns the seed words for the game's generator
+  std::array<uint32_t, 4> begin_game(std::size_t game, std::size_t s1,
+                                     std::size_t s2) {
+    const uint64_t game_stream = stream_for(game);
+    put(TraceTag::kGameBegin);
+    put8(rule_set);
+    put8(static_cast<uint8_t>(s1));
+    put8(static_cast<uint8_t>(s2));
+    put64(seed);
+    put64(game_stream);
+    players_.fill(nullptr);
+    nplayers_ = 0;
+    return stream_seed(seed, game_stream);
+  }
+
+  void add_player(std::size_t index, const void *player, const uint32_t *cards,
+                  std::size_t n) {
+    players_[index] = player;
+    nplayers_ = std::max(nplayers_, index + 1);
+    put_cards(TraceTag::kDeal, static_cast<uint8_t>(index), cards, n);
+  }
+
+  void record_shuffle(const void *player, const uint32_t *cards,
+                      std::size_t n) {
+    for (std::size_t i = 0; i < players_.size(); i++) {
+      if (players_[i] == player) {
+        put_cards(TraceTag::kShuffle, static_cast<uint8_t>(i), cards, n);
+        return;
+      }
+    }
+  }
+
+  //  Winners past the dealt players, kNone or N for a table, are ties
+  void end_game(std::size_t winner, uint64_t nhands) {
+    put(TraceTag::kGameEnd);
+    put8(winner < nplayers_ ? static_cast<uint8_t>(winner) : kTraceNoWinner);
+    put32(static_cast<uint32_t>(nhands));
+  }
+
+private:
+  void put(TraceTag tag) { put8(static_cast<uint8_t>(tag)); }
+  void put8(uint8_t v) { bytes.push_back(v); }
+  void put32(uint32_t v) {
+    for (int i = 0; i < 4; i++) {
+      put8(static_cast<uint8_t>(v >> (8 * i)));
+    }
+  }
+  void put64(uint64_t v) {
+    put32(static_cast<uint32_t>(v));
+    put32(static_cast<uint32_t>(v >> 32));
+  }
+  void put_cards(TraceTag tag, uint8_t player, const uint32_t *cards,
+                 std::size_t n) {
+    put(tag);
+    put8(player);
+    put8(static_cast<uint8_t>(n));
+    for (std::size_t i = 0; i < n; i++) {
+      put8(static_cast<uint8_t>(cards[i]));
+    }
+  }
+
+  std::array<const void *, kTraceMaxPlayers> players_{};
+  std::size_t nplayers_ = 0;
+};
+
+//  Set per worker thread, null when this thread is not tracing
+inline thread_local GameTracer *active_tracer = nullptr;
+//  Set for the duration of a sampled game
+inline thread_local GameTracer *current_trace = nullptr;
+
+struct TracedShuffle {
+  uint8_t player = 0;
+  std::vector<uint8_t> cards;
+};
+
+struct TracedGame {
+  uint8_t rule_set = 0;
+  uint8_t s1 = 0;
+  uint8_t s2 = 0;
+  uint64_t seed = 0;
+  uint64_t stream = 0;
+  std::vector<std::vector<uint8_t>> deal;
+  std::vector<TracedShuffle> shuffles;
+  uint8_t winner = kTraceNoWinner;
+  uint32_t nhands = 0;
+  //  The raw record, for comparing against a replay
+  std::vector<uint8_t> record;
+};
+
+class TraceReader {
+public:
+  TraceReader(const uint8_t *data, std::size_t size)
+      : data_{data}, size_{size} {}
+
+  bool done() const { return pos_ >= size_; }
+  bool ok() const { return ok_; }
+
+  uint8_t get8() {
+    if (pos_ >= size_) {
+      ok_ = false;
+      return 0;
+    }
+    return data_[pos_++];
+  }
+  uint32_t get32() {
+    uint32_t v = 0;
+    for (int i = 0; i < 4; i++) {
+      v |= static_cast<uint32_t>(get8()) << (8 * i);
+    }
+    return v;
+  }
+  uint64_t get64() {
+    const uint64_t lo = get32();
+    return lo | (static_cast<uint64_t>(get32()) << 32);
+  }
+  std::vector<uint8_t> get_cards() {
+    std::vector<uint8_t> cards(get8());
+    for (auto &c : cards) {
+      c = get8();
+    }
+    return cards;
+  }
+  std::size_t pos() const { return pos_; }
+
+private:
+  const uint8_t *data_;
+  std::size_t size_;
+  std::size_t pos_ = 0;
+  bool ok_ = true;
+};
+
+//  Parses the records of a trace body, without the file header
+inline bool parse_trace_records(const std::vector<uint8_t> &bytes,
+                                std::vector<TracedGame> *games) {
+  TraceReader in{bytes.data(), bytes.size()};
+  TracedGame *game = nullptr;
+  std::size_t start = 0;
+  while (!in.done() && in.ok()) {
+    const auto record_start = in.pos();
+    const auto tag = static_cast<TraceTag>(in.get8());
+    if (tag == TraceTag::kGameBegin) {
+      games->emplace_back();
+      game = &games->back();
+      start = record_start;
+      game->rule_set = in.get8();
+      game->s1 = in.get8();
+      game->s2 = in.get8();
+      game->seed = in.get64();
+      game->stream = in.get64();
+      continue;
+    }
+    if (!game) {
+      return false;
+    }
+    switch (tag) {
+    case TraceTag::kDeal: {
+      const auto player = in.get8();
+      if (player != game->deal.size()) {
+        return false;
+      }
+      game->deal.push_back(in.get_cards());
+      break;
+    }
+    case TraceTag::kShuffle: {
+      TracedShuffle shuffle{};
+      shuffle.player = in.get8();
+      shuffle.cards = in.get_cards();
+      game->shuffles.push_back(std::move(shuffle));
+      break;
+    }
+    case TraceTag::kGameEnd: {
+      game->winner = in.get8();
+      game->nhands = in.get32();
+      game->record.assign(bytes.begin() + static_cast<std::ptrdiff_t>(start),
+                          bytes.begin() +
+                              static_cast<std::ptrdiff_t>(in.pos()));
+      game = nullptr;
+      break;
+    }
+    default:
+      return false;
+    }
+  }
+  return in.ok() && game == nullptr;
+}
+
+inline bool write_trace_file(const std::string &path,
+                             const std::vector<const GameTracer *> &tracers) {
+  std::ofstream f{path, std::ios::binary};
+  if (!f) {
+    return false;
+  }
+  f.write(reinterpret_cast<const char *>(kTraceMagic.data()),
+          kTraceMagic.size());
+  f.put(static_cast<char>(kTraceVersion));
+  for (const auto *t : tracers) {
+    f.write(reinterpret_cast<const char *>(t->bytes.data()),
+            static_cast<std::streamsize>(t->bytes.size()));
+  }
+  return static_cast<bool>(f);
+}
+
+inline bool read_trace_file(const std::string &path,
+                            std::vector<TracedGame> *games) {
+  std::ifstream f{path, std::ios::binary};
+  if (!f) {
+    return false;
+  }
+  std::vector<uint8_t> bytes{std::istreambuf_iterator<char>{f},
+                             std::istreambuf_iterator<char>{}};
+  if (bytes.size() < kTraceMagic.size() + 1 ||
+      !std::equal(kTraceMagic.begin(), kTraceMagic.end(), bytes.begin()) ||
+      bytes[kTraceMagic.size()] != kTraceVersion) {
+    return false;
+  }
+  bytes.erase(bytes.begin(),
+              bytes.begin() + static_cast<std::ptrdiff_t>(kTraceMagic.size() + 1));
+  return parse_trace_records(bytes, games);
+}
+
+inline void print_cards(std::ostream &os, const std::vector<uint8_t> &cards) {
+  for (std::size_t i = 0; i < cards.size(); i++) {
+    os << (i ? " " : "") << static_cast<unsigned>(cards[i]);
+  }
+}
+
+inline std::ostream &operator<<(std::ostream &os, const TracedGame &g) {
+  os << "game rule_set=" << static_cast<unsigned>(g.rule_set)
+     << " s1=" << static_cast<unsigned>(g.s1)
+     << " s2=" << static_cast<unsigned>(g.s2) << " seed=" << g.seed
+     << " stream=" << (g.stream >> 32) << ":" << (g.stream & 0xffffffffu)
+     << "\n";
+  for (std::size_t i = 0; i < g.deal.size(); i++) {
+    os << "  deal p" << i << ": ";
+    print_cards(os, g.deal[i]);
+    os << "\n";
+  }
+  for (const auto &s : g.shuffles) {
+    os << "  shuffle p" << static_cast<unsigned>(s.player) << ": ";
+    print_cards(os, s.cards);
+    os << "\n";
+  }
+  os << "  winner ";
+  if (g.winner == kTraceNoWinner) {
+    os << "none";
+  } else {
+    os << "p" << static_cast<unsigned>(g.winner);
+  }
+  os << " after " << g.nhands << " hands\n";
+  return os;
+}
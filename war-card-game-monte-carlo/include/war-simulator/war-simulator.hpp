@@ -8,24 +8,33 @@
 
 #include <algorithm>
 #include <array>
+#include <bit>
 #include <cassert>
 #include <cstdint>
 #include <cstdlib>
 #include <cstring>
 #include <deque>
 #include <iostream>
+#include <initializer_list>
 #include <numeric> // for std::accumulate
 #include <random>
+#include <ranges>
 #include <string>
 #include <utility>
 #include <vector>
 
+#include "war-simulator/card-kernels.hpp"
+#include "war-simulator/progress.hpp"
+#include "war-simulator/rules.hpp"
+#include "war-simulator/trace.hpp"
+
 const std::size_t kMaxCard = 14;
 const std::size_t kDeckSize = 52;
 const std::size_t kMaxRounds = 100000;
 const std::size_t kGameCount = 1000000;
 
-extern std::mt19937 gen;
+//  One generator per simulation thread, defined by the executable
+extern thread_local std::mt19937 gen;
 
 enum class PlayerEnum { kOne = 0, kTwo = 1, kNone = 2 };
 
@@ -38,9 +47,87 @@ struct Strategy {
   void operator()(Player &player, const std::size_t n) { fp(player, n); }
 };
 
+/*
+ * FIFO of cards in contiguous storage so the rank kernels can run over it
+ * directly. Draws advance the head, appends go to the tail and the live range
+ * is moved back to the start of the buffer only when an append would run off
+ * the end. A hand never holds more than a deck so twice that is plenty.
+ * */
+class CardQueue {
+public:
+  static constexpr std::size_t kCapacity = 2 * kDeckSize;
+
+  CardQueue() = default;
+  CardQueue(std::initializer_list<uint32_t> cards) {
+    append(cards.begin(), cards.size());
+  }
+  template <typename It> CardQueue(It first, It last) {
+    for (; first != last; ++first) {
+      push_back(*first);
+    }
+  }
+  template <std::ranges::input_range R>
+  CardQueue(const R &cards) : CardQueue(std::ranges::begin(cards),
+                                        std::ranges::end(cards)) {}
+  CardQueue(const CardQueue &other) { append(other.data(), other.size()); }
+  CardQueue &operator=(const CardQueue &other) {
+    if (this != &other) {
+      clear();
+      append(other.data(), other.size());
+    }
+    return *this;
+  }
+
+  std::size_t size() const { return tail_ - head_; }
+  bool empty() const { return head_ == tail_; }
+  uint32_t *data() { return buf_.data() + head_; }
+  const uint32_t *data() const { return buf_.data() + head_; }
+  uint32_t *begin() { return data(); }
+  uint32_t *end() { return buf_.data() + tail_; }
+  const uint32_t *begin() const { return data(); }
+  const uint32_t *end() const { return buf_.data() + tail_; }
+
+  uint32_t front() const {
+    assert(!empty());
+    return buf_[head_];
+  }
+
+  void pop_front() {
+    assert(!empty());
+    head_++;
+    if (head_ == tail_) {
+      clear();
+    }
+  }
+
+  void push_back(uint32_t card) { append(&card, 1); }
+
+  void append(const uint32_t *cards, std::size_t n) {
+    if (tail_ + n > kCapacity) {
+      compact();
+    }
+    assert(tail_ + n <= kCapacity);
+    std::memcpy(buf_.data() + tail_, cards, n * sizeof(uint32_t));
+    tail_ += n;
+  }
+
+  void clear() { head_ = tail_ = 0; }
+
+private:
+  void compact() {
+    std::memmove(buf_.data(), buf_.data() + head_, size() * sizeof(uint32_t));
+    tail_ -= head_;
+    head_ = 0;
+  }
+
+  std::array<uint32_t, kCapacity> buf_;
+  std::size_t head_ = 0;
+  std::size_t tail_ = 0;
+};
+
 class Player {
 public:
-  std::deque<uint32_t> hand_;
+  CardQueue hand_;
   Strategy strategy_;
   std::vector<uint32_t> pile_;
 
@@ -57,7 +144,7 @@ public:
   void take(uint32_t card) { pile_.push_back(card); }
 
   void combine_pile() {
-    hand_.insert(hand_.end(), pile_.begin(), pile_.end());
+    hand_.append(pile_.data(), pile_.size());
     pile_.clear();
   }
 
@@ -72,7 +159,7 @@ public:
     return valid;
   }
 
-  Player(std::deque<uint32_t> hand, Strategy strategy)
+  Player(CardQueue hand, Strategy strategy)
       : hand_{hand}, strategy_{strategy} {
     assert(is_valid());
   }
@@ -81,8 +168,9 @@ public:
         pile_(std::move(other.pile_))
   // function pointer just copied
   {
-    // After the move, other.hand_ and other.pile_ are left in a valid but empty
-    // state.
+    // After the move, other.pile_ is left in a valid but empty state. The hand
+    // is stored inline so other.hand_ is copied from and cleared.
+    other.hand_.clear();
     assert(is_valid());
     pile_.reserve(kDeckSize);
   }
@@ -90,7 +178,8 @@ public:
   // Custom move assignment
   Player &operator=(Player &&other) noexcept {
     if (this != &other) {
-      hand_ = std::move(other.hand_);
+      hand_ = other.hand_;
+      other.hand_.clear();
       pile_ = std::move(other.pile_);
       strategy_ = other.strategy_;
       pile_.reserve(kDeckSize);
@@ -107,10 +196,11 @@ public:
 
   bool is_valid() const { return flip > 0; }
 
-  WarHand(Player &player) {
+  explicit WarHand(Player &player,
+                   std::size_t war_size = ClassicRules::kWarSize) {
     //  If no cards in hand when a war starts then player loses.
     if (player.hand_size() >= 1) {
-      const std::size_t dump_size = std::min(4ul, player.hand_size());
+      const std::size_t dump_size = std::min(war_size, player.hand_size());
       for (std::size_t i = 0; i < dump_size; i++) {
         const auto card = player.draw();
         assert(card > 1);
@@ -140,11 +230,55 @@ template <typename T> inline void shuffle_hand(T &v) {
   std::shuffle(v.begin(), v.end(), gen);
 }
 
+//  Shuffle made by a strategy, recorded when the game is being traced
+inline void shuffle_player_hand(Player &player) {
+  shuffle_hand(player.hand_);
+  if (GameTracer *trace = current_trace) {
+    trace->record_shuffle(&player, player.hand_.data(), player.hand_size());
+  }
+}
+
+/*
+ * Starts a sampled game: reseeds this thread's generator from the game's
+ * stream so the deal and all later shuffles can be reproduced.
+ * */
+inline GameTracer *begin_traced_game(std::size_t game, const Strategy &s1,
+                                     const Strategy &s2) {
+  GameTracer *trace = active_tracer;
+  if (!trace || !trace->sampled(game)) {
+    return nullptr;
+  }
+  const auto words = trace->begin_game(game, s1.id, s2.id);
+  std::seed_seq seq(words.begin(), words.end());
+  gen.seed(seq);
+  current_trace = trace;
+  return trace;
+}
+
+inline void end_traced_game(GameTracer *trace, std::size_t winner,
+                            uint64_t nhands) {
+  trace->end_game(winner, nhands);
+  current_trace = nullptr;
+}
+
+template <typename T> inline uint64_t rank_sum(const T &arr) {
+  if constexpr (std::ranges::contiguous_range<const T>) {
+    return card_kernels().rank_sum(std::ranges::data(arr),
+                                   std::ranges::size(arr));
+  } else {
+    return std::accumulate(arr.begin(), arr.end(), uint64_t{0});
+  }
+}
+
 template <typename T> inline double average(const T &arr) {
-  return arr.empty()
-             ? 0.0
-             : static_cast<double>(std::accumulate(arr.begin(), arr.end(), 0)) /
-                   arr.size();
+  return arr.empty() ? 0.0 : static_cast<double>(rank_sum(arr)) / arr.size();
+}
+
+inline std::array<uint32_t, kMaxCard + 1> rank_histogram(const uint32_t *cards,
+                                                         std::size_t n) {
+  std::array<uint32_t, kMaxCard + 1> hist{};
+  card_kernels().rank_histogram(cards, n, hist.data(), hist.size());
+  return hist;
 }
 
 template <typename T, typename U>
@@ -158,32 +292,48 @@ inline std::size_t count_card_type(const T &arr, const std::vector<U> &types) {
   return cnt;
 }
 
+/*
+ * a / b > c / d compared as a * d > c * b. The card counts are bounded by the
+ * deck size so the products cannot overflow. An empty side makes the product
+ * with it zero, so the comparison is false, matching the NaN comparison of the
+ * division form.
+ * */
+inline bool ratio_greater(uint64_t num_hand, uint64_t nhand, uint64_t num_pile,
+                          uint64_t npile) {
+  return num_hand * npile > num_pile * nhand;
+}
+
 struct AverageEnrichment {
   static bool enriched(const Player &player) {
-    return average(player.hand_) > average(player.pile_);
+    const auto nhand = player.hand_size();
+    const auto npile = player.pile_.size();
+    //  The average of an empty set of cards is zero
+    if (nhand == 0 || npile == 0) {
+      return nhand != 0;
+    }
+    return ratio_greater(rank_sum(player.hand_), nhand,
+                         rank_sum(player.pile_), npile);
   }
 };
 
-struct AcesEnrichment {
+/*
+ * Compares the fraction of hand and pile with rank in [kLow, kHigh].
+ * */
+template <uint32_t kLow, uint32_t kHigh> struct RankClassEnrichment {
   static bool enriched(const Player &player) {
-    const std::vector<uint32_t> aces{kMaxCard};
-    auto nhand = count_card_type(player.hand_, aces);
-    auto npile = count_card_type(player.pile_, aces);
-    return static_cast<double>(nhand) / player.hand_size() >
-           static_cast<double>(npile) / player.pile_.size();
+    const auto &k = card_kernels();
+    const auto nhand = k.count_rank_range(player.hand_.data(),
+                                          player.hand_size(), kLow, kHigh);
+    const auto npile = k.count_rank_range(player.pile_.data(),
+                                          player.pile_.size(), kLow, kHigh);
+    return ratio_greater(nhand, player.hand_size(), npile,
+                         player.pile_.size());
   }
 };
 
-struct FaceCardEnrichment {
-  static bool enriched(const Player &player) {
-    const std::vector<uint32_t> face_cards{kMaxCard, kMaxCard - 1, kMaxCard - 2,
-                                           kMaxCard - 3};
-    auto nhand = count_card_type(player.hand_, face_cards);
-    auto npile = count_card_type(player.pile_, face_cards);
-    return static_cast<double>(nhand) / player.hand_size() >
-           static_cast<double>(npile) / player.pile_.size();
-  }
-};
+struct AcesEnrichment : RankClassEnrichment<kMaxCard, kMaxCard> {};
+
+struct FaceCardEnrichment : RankClassEnrichment<kMaxCard - 3, kMaxCard> {};
 
 template <typename EnrichmentPolicy, bool ShuffleWhenEnriched>
 inline void combine_strategy(Player &player, std::size_t ncards) {
@@ -196,7 +346,7 @@ inline void combine_strategy(Player &player, std::size_t ncards) {
   if (combine) {
     player.combine_pile();
     if (shuffle) {
-      shuffle_hand(player.hand_);
+      shuffle_player_hand(player);
     }
   }
 }
@@ -212,13 +362,13 @@ inline void combine_only_strategy(Player &player,
 
 inline void always_shuffle_strategy(Player &player, const std::size_t ncards) {
   player.combine_pile();
-  shuffle_hand(player.hand_);
+  shuffle_player_hand(player);
 }
 
 inline void combine_and_shuffle_strategy(Player &player,
                                          const std::size_t ncards) {
   combine_only_strategy(player, ncards);
-  shuffle_hand(player.hand_);
+  shuffle_player_hand(player);
 }
 
 inline void decide_shuffle(Player &p1, Player &p2, const std::size_t ncards) {
@@ -257,8 +407,10 @@ struct GameResult {
   std::size_t nhands = 0;
 };
 
+template <typename R = ClassicRules>
 inline PlayerEnum play_hand(const uint32_t c1, const uint32_t c2, Player &p1,
                             Player &p2, GameResult *result) {
+  static_assert(R::kPlayers == 2, "use play_table_hand for 3+ players");
 
   assert(c1 > 0);
   assert(c2 > 0);
@@ -270,32 +422,35 @@ inline PlayerEnum play_hand(const uint32_t c1, const uint32_t c2, Player &p1,
     winner = PlayerEnum::kOne;
   } else if (c1 < c2) {
     winner = PlayerEnum::kTwo;
+  } else if constexpr (R::kTie == TieRule::kReturnCards) {
+    p1.take(c1);
+    p2.take(c2);
+    return PlayerEnum::kNone;
   } else {
     // War
     assert(c1);
     assert(c2);
 
-    // If a players last card is a war then they lose
-    if (p1.ncards() == 0) {
+    // If a player cannot put up a war hand then they lose
+    if (p1.ncards() < R::kMinWarCards) {
       p2.take(c1);
       p2.take(c2);
       return PlayerEnum::kTwo;
     }
-    if (p2.ncards() == 0) {
+    if (p2.ncards() < R::kMinWarCards) {
       p1.take(c1);
       p1.take(c2);
       return PlayerEnum::kOne;
     }
 
-    const std::size_t kWarSize = 4;
-    decide_shuffle(p1, p2, kWarSize);
+    decide_shuffle(p1, p2, R::kWarSize);
 
-    const auto wh1 = WarHand{p1};
-    const auto wh2 = WarHand{p2};
+    const auto wh1 = WarHand{p1, R::kWarSize};
+    const auto wh2 = WarHand{p2, R::kWarSize};
     assert(wh1.is_valid());
     assert(wh2.is_valid());
 
-    winner = play_hand(wh1.flip, wh2.flip, p1, p2, result);
+    winner = play_hand<R>(wh1.flip, wh2.flip, p1, p2, result);
 
     std::vector<uint32_t> cards{}; //  flip cards are assiged in play_hand
 
@@ -335,10 +490,10 @@ inline PlayerEnum play_hand(const uint32_t c1, const uint32_t c2, Player &p1,
     }
   }
 
-  //  Cheap shuffle of the two cards
+  //  Cheap shuffle of the two cards, drawn from gen so traced games replay
   uint32_t card1 = c1;
   uint32_t card2 = c2;
-  if (rand() % 2)
+  if (gen() & 1)
     std::swap(card1, card2);
 
   switch (winner) {
@@ -357,6 +512,7 @@ inline PlayerEnum play_hand(const uint32_t c1, const uint32_t c2, Player &p1,
   return winner;
 }
 
+template <typename R = ClassicRules>
 inline GameResult simulate(Player &p1, Player &p2) {
   assert(p1.ncards() == p2.ncards());
   // std::cout << p1.size() << "\t" << p2.size() << std::endl;
@@ -381,7 +537,167 @@ inline GameResult simulate(Player &p1, Player &p2) {
     assert(p1.hand_size());
     assert(p2.hand_size());
 
-    play_hand(p1.draw(), p2.draw(), p1, p2, &result);
+    play_hand<R>(p1.draw(), p2.draw(), p1, p2, &result);
+  }
+  return result;
+}
+
+/*
+ * 3+ player games. Every player with cards flips one, the highest card takes
+ * the pot and players tied for the highest card go to war among themselves.
+ * */
+template <std::size_t N> struct TableResult {
+  //  N when the round limit was hit
+  std::size_t winner = N;
+  std::array<uint64_t, N> war_cards_lost{};
+  std::array<uint64_t, N> nwar_cards_lost{};
+  std::size_t nhands = 0;
+};
+
+inline constexpr uint32_t player_bit(std::size_t i) { return 1u << i; }
+
+template <std::size_t N>
+inline void decide_shuffle(std::array<Player, N> &players, uint32_t mask,
+                           const std::size_t ncards) {
+  bool short_hand = false;
+  for (std::size_t i = 0; i < N; i++) {
+    short_hand |= (mask & player_bit(i)) && players[i].hand_size() < ncards;
+  }
+  if (short_hand) {
+    //  Shuffle event
+    for (std::size_t i = 0; i < N; i++) {
+      if (mask & player_bit(i)) {
+        players[i].strategy_(players[i], ncards);
+      }
+    }
+  }
+}
+
+/*
+ * Plays cards[i] for each player in mask, appending them and any war cards to
+ * pot. Returns the index of the player that takes the pot, or N when the cards
+ * went back to their owners.
+ * */
+template <typename R>
+inline std::size_t
+play_table_hand(std::array<Player, R::kPlayers> &players, uint32_t mask,
+                const std::array<uint32_t, R::kPlayers> &cards,
+                std::vector<uint32_t> &pot, TableResult<R::kPlayers> *result) {
+  constexpr std::size_t N = R::kPlayers;
+  result->nhands += 1;
+
+  uint32_t best = 0;
+  uint32_t tied = 0;
+  for (std::size_t i = 0; i < N; i++) {
+    if (!(mask & player_bit(i))) {
+      continue;
+    }
+    assert(cards[i] > 1);
+    pot.push_back(cards[i]);
+    if (cards[i] > best) {
+      best = cards[i];
+      tied = player_bit(i);
+    } else if (cards[i] == best) {
+      tied |= player_bit(i);
+    }
+  }
+
+  if (std::has_single_bit(tied)) {
+    return std::countr_zero(tied);
+  }
+
+  if constexpr (R::kTie == TieRule::kReturnCards) {
+    for (std::size_t i = 0; i < N; i++) {
+      if (mask & player_bit(i)) {
+        players[i].take(cards[i]);
+      }
+    }
+    pot.clear();
+    return N;
+  } else {
+    // War between the tied players that can put up a war hand
+    uint32_t alive = 0;
+    for (std::size_t i = 0; i < N; i++) {
+      if ((tied & player_bit(i)) && players[i].ncards() >= R::kMinWarCards) {
+        alive |= player_bit(i);
+      }
+    }
+    // Nobody can continue, the first tied player keeps the pot
+    if (alive == 0) {
+      return std::countr_zero(tied);
+    }
+    if (std::has_single_bit(alive)) {
+      return std::countr_zero(alive);
+    }
+
+    decide_shuffle(players, alive, R::kWarSize);
+
+    std::array<uint32_t, N> flips{};
+    std::array<uint64_t, N> dump_sum{};
+    std::array<uint64_t, N> dump_count{};
+    for (std::size_t i = 0; i < N; i++) {
+      if (!(alive & player_bit(i))) {
+        continue;
+      }
+      const auto wh = WarHand{players[i], R::kWarSize};
+      assert(wh.is_valid());
+      flips[i] = wh.flip;
+      for (auto card : wh.dump) {
+        pot.push_back(card);
+        dump_sum[i] += card;
+      }
+      dump_count[i] = wh.dump.size();
+    }
+
+    const auto winner = play_table_hand<R>(players, alive, flips, pot, result);
+    assert(winner < N);
+    for (std::size_t i = 0; i < N; i++) {
+      if ((alive & player_bit(i)) && i != winner) {
+        result->war_cards_lost[i] += dump_sum[i];
+        result->nwar_cards_lost[i] += dump_count[i];
+      }
+    }
+    return winner;
+  }
+}
+
+template <typename R>
+inline TableResult<R::kPlayers>
+simulate_table(std::array<Player, R::kPlayers> &players) {
+  constexpr std::size_t N = R::kPlayers;
+  TableResult<N> result{};
+  std::vector<uint32_t> pot;
+  pot.reserve(kDeckSize);
+
+  for (std::size_t round = 0; round < kMaxRounds; round++) {
+    uint32_t active = 0;
+    for (std::size_t i = 0; i < N; i++) {
+      if (players[i].ncards() > 0) {
+        active |= player_bit(i);
+      }
+    }
+    if (std::popcount(active) <= 1) {
+      assert(active);
+      result.winner = std::countr_zero(active);
+      break;
+    }
+
+    decide_shuffle(players, active, 1);
+    std::array<uint32_t, N> cards{};
+    for (std::size_t i = 0; i < N; i++) {
+      if (active & player_bit(i)) {
+        cards[i] = players[i].draw();
+      }
+    }
+
+    pot.clear();
+    const auto winner = play_table_hand<R>(players, active, cards, pot, &result);
+    if (winner < N) {
+      shuffle_hand(pot);
+      for (auto card : pot) {
+        players[winner].take(card);
+      }
+    }
   }
   return result;
 }
@@ -390,13 +706,91 @@ inline std::pair<Player, Player> make_players(Strategy s1, Strategy s2) {
   const auto deck_array = make_deck();
   std::vector<uint32_t> deck{deck_array.begin(), deck_array.end()};
   shuffle_hand(deck);
-  Player p1{{deck.begin(), deck.begin() + deck.size() / 2}, s1};
-  Player p2{{deck.begin() + deck.size() / 2, deck.end()}, s2};
+  Player p1{CardQueue{deck.begin(), deck.begin() + deck.size() / 2}, s1};
+  Player p2{CardQueue{deck.begin() + deck.size() / 2, deck.end()}, s2};
   return {std::move(p1), std::move(p2)};
 }
 
-inline Results simulate_strategy(Strategy s1, Strategy s2,
-                                 const std::size_t ngames = 10) {
+/*
+ * Deals the deck round robin, player 0 plays the first strategy and everyone
+ * else the second.
+ * */
+template <std::size_t N>
+inline std::array<Player, N> make_table(Strategy first, Strategy rest) {
+  const auto deck_array = make_deck();
+  std::vector<uint32_t> deck{deck_array.begin(), deck_array.end()};
+  shuffle_hand(deck);
+  std::array<CardQueue, N> hands{};
+  for (std::size_t i = 0; i < deck.size(); i++) {
+    hands[i % N].push_back(deck[i]);
+  }
+  return [&]<std::size_t... I>(std::index_sequence<I...>) {
+    return std::array<Player, N>{Player{hands[I], I == 0 ? first : rest}...};
+  }(std::make_index_sequence<N>{});
+}
+
+/*
+ * With 3+ players the P1 column counts wins by player 0 and the P2 column wins
+ * by any of the others.
+ * */
+template <typename R>
+inline Results simulate_table_strategy(Strategy s1, Strategy s2,
+                                       const std::size_t ngames,
+                                       PairProgress *progress) {
+  constexpr std::size_t N = R::kPlayers;
+  Results result_struct{s1.id, s2.id};
+  result_struct.ngames = ngames;
+
+  uint64_t p1_war_cards = 0;
+  uint64_t p1_war_count = 0;
+  uint64_t p2_war_cards = 0;
+  uint64_t p2_war_count = 0;
+
+  for (std::size_t i = 0; i < ngames; i++) {
+    GameTracer *trace = begin_traced_game(i, s1, s2);
+    auto players = make_table<N>(s1, s2);
+    if (trace) {
+      for (std::size_t p = 0; p < N; p++) {
+        trace->add_player(p, &players[p], players[p].hand_.data(),
+                          players[p].hand_size());
+      }
+    }
+    const auto game_result = simulate_table<R>(players);
+    if (trace) {
+      end_traced_game(trace, game_result.winner, game_result.nhands);
+    }
+
+    result_struct.nhands += game_result.nhands;
+    if (progress) {
+      progress->publish(i + 1, result_struct.nhands);
+    }
+
+    p1_war_cards += game_result.war_cards_lost[0];
+    p1_war_count += game_result.nwar_cards_lost[0];
+    for (std::size_t p = 1; p < N; p++) {
+      p2_war_cards += game_result.war_cards_lost[p];
+      p2_war_count += game_result.nwar_cards_lost[p];
+    }
+
+    if (game_result.winner == 0) {
+      result_struct.p1 += 1;
+    } else if (game_result.winner < N) {
+      result_struct.p2 += 1;
+    } else {
+      result_struct.tie += 1;
+    }
+  }
+  result_struct.average_p1_war_lost =
+      static_cast<double>(p1_war_cards) / p1_war_count;
+  result_struct.average_p2_war_lost =
+      static_cast<double>(p2_war_cards) / p2_war_count;
+  return result_struct;
+}
+
+template <typename R>
+inline Results simulate_pair_strategy(Strategy s1, Strategy s2,
+                                      const std::size_t ngames,
+                                      PairProgress *progress) {
   Results result_struct{s1.id, s2.id};
 
   uint64_t total_p1_war_cards = 0;
@@ -407,12 +801,24 @@ inline Results simulate_strategy(Strategy s1, Strategy s2,
   result_struct.ngames = ngames;
 
   for (std::size_t i = 0; i < ngames; i++) {
+    GameTracer *trace = begin_traced_game(i, s1, s2);
     auto players = make_players(s1, s2);
     Player &p1 = (players.first);
     Player &p2 = (players.second);
-    const auto game_result = simulate(p1, p2);
+    if (trace) {
+      trace->add_player(0, &p1, p1.hand_.data(), p1.hand_size());
+      trace->add_player(1, &p2, p2.hand_.data(), p2.hand_size());
+    }
+    const auto game_result = simulate<R>(p1, p2);
+    if (trace) {
+      end_traced_game(trace, static_cast<std::size_t>(game_result.winner),
+                      game_result.nhands);
+    }
 
     result_struct.nhands += game_result.nhands;
+    if (progress) {
+      progress->publish(i + 1, result_struct.nhands);
+    }
 
     for (auto c : game_result.war_hands_p1_lost) {
       total_p1_war_cards += c;
@@ -446,6 +852,17 @@ inline Results simulate_strategy(Strategy s1, Strategy s2,
   return result_struct;
 }
 
+template <typename R = ClassicRules>
+inline Results simulate_strategy(Strategy s1, Strategy s2,
+                                 const std::size_t ngames = 10,
+                                 PairProgress *progress = nullptr) {
+  if constexpr (R::kPlayers > 2) {
+    return simulate_table_strategy<R>(s1, s2, ngames, progress);
+  } else {
+    return simulate_pair_strategy<R>(s1, s2, ngames, progress);
+  }
+}
+
 const std::vector<Strategy> strategies{{
     {0, &combine_and_shuffle_strategy},
     {1, &always_shuffle_strategy},
@@ -457,3 +874,48 @@ const std::vector<Strategy> strategies{{
     {7, &combine_strategy<FaceCardEnrichment, true>},
     {8, &combine_strategy<FaceCardEnrichment, false>},
 }};
+
+typedef Results (*RuleSet_fp_t)(Strategy, Strategy, const std::size_t,
+                                PairProgress *);
+
+struct RuleSet {
+  const char *name;
+  RuleSet_fp_t simulate;
+};
+
+const std::vector<RuleSet> rule_sets{{
+    {"classic", &simulate_strategy<ClassicRules>},
+    {"one-down", &simulate_strategy<Rules<1>>},
+    {"five-down", &simulate_strategy<Rules<5>>},
+    {"forfeit",
+     &simulate_strategy<Rules<3, TieRule::kWar, ShortWarRule::kForfeit>>},
+    {"return-ties", &simulate_strategy<Rules<3, TieRule::kReturnCards>>},
+    {"3p", &simulate_strategy<Rules<3, TieRule::kWar,
+                                    ShortWarRule::kPlayRemaining, 3>>},
+    {"4p", &simulate_strategy<Rules<3, TieRule::kWar,
+                                    ShortWarRule::kPlayRemaining, 4>>},
+}};
+
+/*
+ * Re-runs a traced game from its stream and returns the new record, which
+ * matches game.record when the replay is faithful.
+ * */
+inline std::vector<uint8_t> replay_game(const TracedGame &game) {
+  if (game.rule_set >= rule_sets.size() || game.s1 >= strategies.size() ||
+      game.s2 >= strategies.size()) {
+    return {};
+  }
+  GameTracer tracer{};
+  tracer.seed = game.seed;
+  tracer.rule_set = game.rule_set;
+  tracer.sample_every = 1;
+  tracer.fixed_stream = true;
+  tracer.stream = game.stream;
+
+  GameTracer *previous = active_tracer;
+  active_tracer = &tracer;
+  rule_sets[game.rule_set].simulate(strategies[game.s1], strategies[game.s2],
+                                    1, nullptr);
+  active_tracer = previous;
+  return tracer.bytes;
+}
@@ -5,11 +5,17 @@
 #include <random>
 #include <vector>
 
+#include "war-simulator/affinity.hpp"
 #include "war-simulator/war-simulator.hpp"
+#include <chrono>
 #include <future>
+#include <memory>
+#include <string_view>
 
+//  Only read on the main thread, std::random_device is not thread safe
 static std::random_device rd;
-std::mt19937 gen(rd());
+//  Seeded by each worker from a value drawn on the main thread
+thread_local std::mt19937 gen;
 
 static inline void print_vector(std::vector<Results> &results) {
   std::cout << "S1, S2, P1, P2, Tie, P1 Turn Loss Average, P2 Turn Loss "
@@ -19,25 +25,155 @@ static inline void print_vector(std::vector<Results> &results) {
   }
 }
 
+static void print_usage(const char *name) {
+  std::cerr << "Usage: " << name << " [options] N_GAMES [indices...]\n"
+            << "Options:\n"
+            << "  --progress[=SECONDS]       status lines on stderr\n"
+            << "  --progress-json[=SECONDS]  JSON lines on stderr\n"
+            << "  --pin                      pin workers to cores, spread "
+               "across sockets\n"
+            << "  --rules=NAME               rule set, one of:";
+  for (const auto &r : rule_sets) {
+    std::cerr << " " << r.name;
+  }
+  std::cerr << "\n"
+            << "  --seed=N                   run seed for traced games\n"
+            << "  --trace=FILE               write sampled game traces\n"
+            << "  --trace-every=N            trace every Nth game of each "
+               "pair (default 1000)\n"
+            << "  --replay=FILE              print and replay a trace file\n";
+}
+
+//  Prints each traced game and checks that replaying it reproduces the trace
+static int replay_trace(const std::string &path) {
+  std::vector<TracedGame> games;
+  if (!read_trace_file(path, &games)) {
+    std::cerr << "Could not read trace " << path << "\n";
+    return 1;
+  }
+  std::size_t mismatches = 0;
+  for (const auto &game : games) {
+    std::cout << game;
+    const bool same = replay_game(game) == game.record;
+    std::cout << "  replay " << (same ? "matches" : "DIFFERS") << "\n";
+    mismatches += static_cast<std::size_t>(!same);
+  }
+  std::cout << games.size() << " games, " << mismatches
+            << " replay mismatches\n";
+  return mismatches ? 1 : 0;
+}
+
+static void print_socket_throughput(const std::vector<WorkerPlacement> &workers,
+                                    double wall_seconds) {
+  for (const auto &s : socket_throughput(workers)) {
+    if (s.workers == 0) {
+      continue;
+    }
+    std::cerr << "socket " << s.socket << ": " << s.workers << " workers, "
+              << s.games << " games, "
+              << static_cast<double>(s.games) / wall_seconds << " games/s, "
+              << static_cast<double>(s.hands) / wall_seconds << " hands/s, "
+              << static_cast<double>(s.hands) / s.worker_seconds
+              << " hands/s per worker\n";
+  }
+}
+
+//  Matches --name or --name=value, value is empty when not given
+static bool match_option(std::string_view arg, std::string_view name,
+                         std::string_view *value) {
+  if (!arg.starts_with(name)) {
+    return false;
+  }
+  arg.remove_prefix(name.size());
+  if (arg.empty()) {
+    *value = {};
+    return true;
+  }
+  if (arg.front() == '=') {
+    *value = arg.substr(1);
+    return true;
+  }
+  return false;
+}
+
 int main(int argc, const char *argv[]) {
   char *end = nullptr;
 
-  if (argc < 2) {
-    std::cerr << "Usage: " << argv[0] << " N_GAMES [indices...]\n";
+  ProgressFormat progress_format = ProgressFormat::kNone;
+  double progress_interval_s = 1.0;
+  bool pin_workers = false;
+  const RuleSet *rules = &rule_sets.front();
+  uint64_t seed = (static_cast<uint64_t>(rd()) << 32) | rd();
+  std::string trace_path;
+  std::size_t trace_every = 1000;
+
+  std::vector<const char *> args;
+  for (int i = 1; i < argc; i++) {
+    const std::string_view arg{argv[i]};
+    std::string_view value;
+    bool progress_option = false;
+    if (!arg.starts_with("--")) {
+      args.push_back(argv[i]);
+    } else if (match_option(arg, "--progress-json", &value)) {
+      progress_format = ProgressFormat::kJson;
+      progress_option = true;
+    } else if (match_option(arg, "--progress", &value)) {
+      progress_format = ProgressFormat::kText;
+      progress_option = true;
+    } else if (arg == "--pin") {
+      pin_workers = true;
+    } else if (match_option(arg, "--rules", &value) && !value.empty()) {
+      const auto it = std::find_if(
+          rule_sets.begin(), rule_sets.end(),
+          [&](const RuleSet &r) { return value == r.name; });
+      if (it == rule_sets.end()) {
+        std::cerr << "Unknown rule set " << value << "\n";
+        print_usage(argv[0]);
+        return 1;
+      }
+      rules = &*it;
+    } else if (match_option(arg, "--seed", &value) && !value.empty()) {
+      seed = strtoull(std::string{value}.c_str(), &end, 0);
+    } else if (match_option(arg, "--trace-every", &value) && !value.empty()) {
+      trace_every = strtoul(std::string{value}.c_str(), &end, 10);
+      if (trace_every == 0) {
+        std::cerr << "Invalid trace interval " << value << "\n";
+        return 1;
+      }
+    } else if (match_option(arg, "--trace", &value) && !value.empty()) {
+      trace_path = value;
+    } else if (match_option(arg, "--replay", &value) && !value.empty()) {
+      return replay_trace(std::string{value});
+    } else {
+      std::cerr << "Unknown option " << arg << "\n";
+      print_usage(argv[0]);
+      return 1;
+    }
+    if (progress_option && !value.empty()) {
+      progress_interval_s = strtod(std::string{value}.c_str(), &end);
+      if (progress_interval_s <= 0) {
+        std::cerr << "Invalid progress interval " << value << "\n";
+        return 1;
+      }
+    }
+  }
+
+  if (args.empty()) {
+    print_usage(argv[0]);
     return 1;
   }
 
   // number of games
-  std::size_t n_games = strtoul(argv[1], &end, 10);
+  std::size_t n_games = strtoul(args[0], &end, 10);
   if (n_games == 0) {
     n_games = kGameCount;
   }
 
   // strategy indices from CLI args
   std::vector<std::size_t> selected_indices;
-  if (argc > 2) {
-    for (int i = 2; i < argc; i++) {
-      std::size_t idx = strtoul(argv[i], &end, 10);
+  if (args.size() > 1) {
+    for (std::size_t i = 1; i < args.size(); i++) {
+      std::size_t idx = strtoul(args[i], &end, 10);
       if (idx >= strategies.size()) {
         std::cerr << "Invalid strategy index " << idx << " (max allowed "
                   << strategies.size() - 1 << ")\n";
@@ -53,15 +189,71 @@ int main(int argc, const char *argv[]) {
     }
   }
 
-  // run matrix of chosen strategies
-  std::vector<std::future<Results>> futures;
+  // per pair progress counters, each on its own cache line
+  std::vector<std::unique_ptr<PairProgress>> progress;
   for (auto i : selected_indices) {
     for (auto j : selected_indices) {
-      futures.push_back(std::async(std::launch::async, [=]() {
-        return simulate_strategy(strategies[i], strategies[j], n_games);
-      }));
+      auto p = std::make_unique<PairProgress>();
+      p->s1 = i;
+      p->s2 = j;
+      p->target_games = n_games;
+      progress.push_back(std::move(p));
     }
   }
+  ProgressReporter reporter{
+      progress, progress_format,
+      std::chrono::milliseconds{
+          static_cast<long long>(progress_interval_s * 1000)}};
+
+  // worker k runs on cpus[k % cpus.size()] when pinning
+  const auto cpus = pin_workers ? worker_cpus() : std::vector<CpuInfo>{};
+  if (pin_workers && cpus.empty()) {
+    std::cerr << "Worker pinning is not supported on this system\n";
+  }
+  std::vector<WorkerPlacement> placements(progress.size());
+
+  // one tracer per pair, written to the trace file in pair order
+  std::vector<std::unique_ptr<GameTracer>> tracers;
+  if (!trace_path.empty()) {
+    for (std::size_t k = 0; k < progress.size(); k++) {
+      auto t = std::make_unique<GameTracer>();
+      t->seed = seed;
+      t->pair = static_cast<uint32_t>(k);
+      t->rule_set = static_cast<uint8_t>(rules - rule_sets.data());
+      t->sample_every = trace_every;
+      tracers.push_back(std::move(t));
+    }
+  }
+  const auto start = std::chrono::steady_clock::now();
+
+  // run matrix of chosen strategies
+  std::vector<std::future<Results>> futures;
+  for (std::size_t k = 0; k < progress.size(); k++) {
+    PairProgress *pp = progress[k].get();
+    WorkerPlacement *placement = &placements[k];
+    GameTracer *tracer = tracers.empty() ? nullptr : tracers[k].get();
+    if (!cpus.empty()) {
+      placement->cpu = cpus[k % cpus.size()];
+    }
+    const RuleSet_fp_t simulate_pair = rules->simulate;
+    const uint32_t worker_seed = rd();
+    futures.push_back(std::async(std::launch::async, [=]() {
+      if (placement->cpu.cpu >= 0) {
+        placement->pinned = pin_current_thread(placement->cpu.cpu);
+      }
+      gen.seed(worker_seed);
+      active_tracer = tracer;
+      const auto worker_start = std::chrono::steady_clock::now();
+      auto result = simulate_pair(strategies[pp->s1], strategies[pp->s2],
+                                  n_games, pp);
+      placement->seconds = std::chrono::duration<double>(
+                               std::chrono::steady_clock::now() - worker_start)
+                               .count();
+      placement->games = result.ngames;
+      placement->hands = result.nhands;
+      return result;
+    }));
+  }
 
   // collect results
   std::vector<Results> results;
@@ -69,6 +261,24 @@ int main(int argc, const char *argv[]) {
   for (auto &fut : futures) {
     results.push_back(fut.get());
   }
+  reporter.stop();
+
+  if (!tracers.empty()) {
+    std::vector<const GameTracer *> sinks;
+    for (const auto &t : tracers) {
+      sinks.push_back(t.get());
+    }
+    if (!write_trace_file(trace_path, sinks)) {
+      std::cerr << "Could not write trace " << trace_path << "\n";
+    }
+  }
+
+  if (!cpus.empty()) {
+    print_socket_throughput(
+        placements, std::chrono::duration<double>(
+                        std::chrono::steady_clock::now() - start)
+                        .count());
+  }
 
   print_vector(results);
   return 0;
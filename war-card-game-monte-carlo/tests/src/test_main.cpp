@@ -2,7 +2,7 @@
 #include <gtest/gtest.h>
 
 static std::random_device rd;
-std::mt19937 gen(rd());
+thread_local std::mt19937 gen(rd());
 
 // Fixture for Player setup
 struct PlayerTest : public ::testing::Test {
@@ -35,6 +35,45 @@ TEST(UtilTest, CountCardType) {
   EXPECT_EQ(count_card_type(v, aces), 2);
 }
 
+// --- card kernels ---
+TEST(KernelTest, DispatchedMatchesScalar) {
+  const auto deck = make_deck();
+  const auto &k = card_kernels();
+  for (std::size_t n = 0; n <= deck.size(); n++) {
+    EXPECT_EQ(k.rank_sum(deck.data(), n),
+              scalar_kernels::rank_sum(deck.data(), n));
+    EXPECT_EQ(k.count_rank_range(deck.data(), n, 11, 14),
+              scalar_kernels::count_rank_range(deck.data(), n, 11, 14));
+  }
+}
+
+TEST(KernelTest, RankHistogram) {
+  const auto deck = make_deck();
+  const auto hist = rank_histogram(deck.data(), deck.size());
+  EXPECT_EQ(hist[0], 0u);
+  EXPECT_EQ(hist[1], 0u);
+  for (uint32_t c = 2; c <= kMaxCard; c++) {
+    EXPECT_EQ(hist[c], 4u);
+  }
+}
+
+// --- CardQueue ---
+TEST(CardQueueTest, FifoAcrossCompaction) {
+  CardQueue q{};
+  uint32_t next_in = 0;
+  uint32_t next_out = 0;
+  for (std::size_t round = 0; round < 10; round++) {
+    for (std::size_t i = 0; i < kDeckSize; i++) {
+      q.push_back(next_in++);
+    }
+    for (std::size_t i = 0; i < kDeckSize - 1; i++) {
+      EXPECT_EQ(q.front(), next_out++);
+      q.pop_front();
+    }
+  }
+  EXPECT_EQ(q.size(), 10u);
+}
+
 TEST(UtilTest, DeckRange) {
   auto deck = make_deck();
   auto min_card = *std::min_element(deck.begin(), deck.end());
@@ -92,6 +131,11 @@ TEST_F(PlayerTest, AcesEnrichmentFalseWhenPileHasMoreAces) {
   EXPECT_FALSE(AcesEnrichment::enriched(p));
 }
 
+TEST_F(PlayerTest, AcesEnrichmentFalseWhenPileEmpty) {
+  auto p = make_player({14, 5});
+  EXPECT_FALSE(AcesEnrichment::enriched(p));
+}
+
 // --- FaceCardEnrichment ---
 TEST_F(PlayerTest, FaceCardEnrichmentTrueWhenHandHasFaceCards) {
   auto p = make_player({11, 12, 13}, {2, 3, 4});
@@ -322,3 +366,142 @@ TEST(DeckTest, ValuesAndAverage) {
   // Average = (2+3+...+14)/13 = 8, repeated 4 times still 8
   EXPECT_DOUBLE_EQ(deck_avg, 8.0);
 }
+
+// --- Rule variants ---
+TEST(RulesTest, OneDownWarUsesTwoCards) {
+  auto p1 = make_player({4, 9, 2});
+  auto p2 = make_player({5, 3, 2});
+  GameResult result{};
+
+  auto winner = play_hand<Rules<1>>(6, 6, p1, p2, &result);
+
+  EXPECT_EQ(winner, PlayerEnum::kOne);
+  EXPECT_EQ(result.nhands, 2);
+  EXPECT_EQ(p1.hand_size(), 1u); // one face down, one flipped
+  EXPECT_EQ(p2.hand_size(), 1u);
+  EXPECT_EQ(p1.ncards() + p2.ncards(), 8u);
+}
+
+TEST(RulesTest, ReturnTiesGivesCardsBack) {
+  auto p1 = make_player({});
+  auto p2 = make_player({});
+  GameResult result{};
+
+  auto winner =
+      play_hand<Rules<3, TieRule::kReturnCards>>(7, 7, p1, p2, &result);
+
+  EXPECT_EQ(winner, PlayerEnum::kNone);
+  EXPECT_EQ(p1.ncards(), 1u);
+  EXPECT_EQ(p2.ncards(), 1u);
+}
+
+TEST(RulesTest, ForfeitShortWarHand) {
+  auto p1 = make_player({5, 6});
+  auto p2 = make_player({5, 6, 7, 8});
+  GameResult result{};
+
+  auto winner =
+      play_hand<Rules<3, TieRule::kWar, ShortWarRule::kForfeit>>(9, 9, p1, p2,
+                                                                 &result);
+
+  EXPECT_EQ(winner, PlayerEnum::kTwo);
+  EXPECT_EQ(result.nhands, 1);
+  EXPECT_EQ(p1.ncards(), 2u);
+  EXPECT_EQ(p2.ncards(), 6u);
+}
+
+TEST(RulesTest, ThreePlayerWarBetweenTiedPlayers) {
+  using R = Rules<3, TieRule::kWar, ShortWarRule::kPlayRemaining, 3>;
+  std::array<Player, 3> players{make_player({2, 3, 4, 5}),
+                                make_player({2, 3, 4, 9}),
+                                make_player({2, 3, 4, 14})};
+  TableResult<3> result{};
+  std::vector<uint32_t> pot;
+
+  // player 2 is out of the war, the flip is between players 0 and 1
+  const auto winner = play_table_hand<R>(players, 0b111, {10, 10, 3}, pot,
+                                         &result);
+
+  EXPECT_EQ(winner, 1u);
+  EXPECT_EQ(result.nhands, 2u);
+  EXPECT_EQ(pot.size(), 3u + 8u);
+  EXPECT_EQ(players[2].hand_size(), 4u);
+  EXPECT_EQ(result.nwar_cards_lost[0], 3u);
+  EXPECT_EQ(result.war_cards_lost[0], 9u);
+}
+
+TEST(RulesTest, TableGameAccountsForAllCards) {
+  using R = Rules<3, TieRule::kWar, ShortWarRule::kPlayRemaining, 4>;
+  for (int i = 0; i < 5; i++) {
+    auto players = make_table<4>(strategies[0], strategies[2]);
+    const auto result = simulate_table<R>(players);
+
+    std::size_t total = 0;
+    for (const auto &p : players) {
+      total += p.ncards();
+    }
+    EXPECT_EQ(total, kDeckSize);
+    ASSERT_LT(result.winner, 4u);
+    EXPECT_EQ(players[result.winner].ncards(), kDeckSize);
+  }
+}
+
+// --- Traces ---
+TEST(TraceTest, SampledGamesReplay) {
+  GameTracer tracer{};
+  tracer.seed = 1234;
+  tracer.pair = 7;
+  tracer.sample_every = 3;
+  active_tracer = &tracer;
+  simulate_strategy(strategies[3], strategies[0], 7);
+  active_tracer = nullptr;
+
+  std::vector<TracedGame> games;
+  ASSERT_TRUE(parse_trace_records(tracer.bytes, &games));
+  ASSERT_EQ(games.size(), 3u); // games 0, 3 and 6
+  for (const auto &game : games) {
+    EXPECT_EQ(game.s1, 3u);
+    EXPECT_EQ(game.s2, 0u);
+    EXPECT_EQ(game.stream >> 32, 7u);
+    ASSERT_EQ(game.deal.size(), 2u);
+    EXPECT_EQ(game.deal[0].size() + game.deal[1].size(), kDeckSize);
+    EXPECT_FALSE(game.shuffles.empty());
+    EXPECT_EQ(replay_game(game), game.record);
+  }
+}
+
+TEST(TraceTest, TiesHaveNoWinner) {
+  const std::array<uint32_t, 2> cards{2, 14};
+  GameTracer tracer{};
+  // two player games report a tie as PlayerEnum::kNone, tables as N
+  for (const std::size_t nplayers : {2u, 3u}) {
+    tracer.begin_game(0, 0, 0);
+    for (std::size_t p = 0; p < nplayers; p++) {
+      tracer.add_player(p, &cards[p % 2], cards.data(), cards.size());
+    }
+    tracer.end_game(nplayers, 100);
+  }
+  tracer.begin_game(1, 0, 0);
+  tracer.add_player(0, &cards[0], cards.data(), cards.size());
+  tracer.add_player(1, &cards[1], cards.data(), cards.size());
+  tracer.end_game(static_cast<std::size_t>(PlayerEnum::kTwo), 5);
+
+  std::vector<TracedGame> games;
+  ASSERT_TRUE(parse_trace_records(tracer.bytes, &games));
+  ASSERT_EQ(games.size(), 3u);
+  EXPECT_EQ(games[0].winner, kTraceNoWinner);
+  EXPECT_EQ(games[1].winner, kTraceNoWinner);
+  EXPECT_EQ(games[2].winner, 1u);
+}
+
+TEST(TraceTest, TruncatedTraceRejected) {
+  GameTracer tracer{};
+  tracer.sample_every = 1;
+  active_tracer = &tracer;
+  simulate_strategy(strategies[0], strategies[0], 1);
+  active_tracer = nullptr;
+
+  std::vector<TracedGame> games;
+  tracer.bytes.pop_back();
+  EXPECT_FALSE(parse_trace_records(tracer.bytes, &games));
+}